@@ -147,7 +147,7 @@ bool ACTIVE_TASK_SET::poll() {
         }
     }
     if (action) {
-        gstate.set_client_state_dirty("ACTIVE_TASK_SET::poll");
+        gstate.journal_active_tasks();
     }
 
     return action;
@@ -122,7 +122,7 @@ static FILE_REF* make_file(
         fip->max_nbytes = 1e9;
         fip->upload_urls.add(string("foobar"));
     }
-    gstate.file_infos.push_back(fip);
+    gstate.add_file_info(fip);
     FILE_REF * fref = new FILE_REF;
     if (log_name) {
         strcpy(fref->open_name, log_name);
@@ -158,7 +158,7 @@ static WORKUNIT* make_workunit(APP_VERSION *av) {
     wu->rsc_memory_bound = 1e9;
     wu->rsc_disk_bound = 1e9;
     wu->version_num = av->version_num;
-    gstate.workunits.push_back(wu);
+    gstate.add_workunit(wu);
     return wu;
 }
 
@@ -172,7 +172,7 @@ static RESULT* make_result(APP_VERSION *av, WORKUNIT* wu) {
     res->app = av->app;
     res->report_deadline = dtime()+86400;
     res->_state = RESULT_FILES_DOWNLOADED;
-    gstate.results.push_back(res);
+    gstate.add_result(res);
     return res;
 }
 
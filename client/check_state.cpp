@@ -222,6 +222,10 @@ void CLIENT_STATE::free_mem() {
         delete res;
     }
 
+    file_info_index.clear();
+    workunit_index.clear();
+    result_index.clear();
+
     active_tasks.free_mem();
 
     message_descs.cleanup();
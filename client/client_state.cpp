@@ -32,6 +32,9 @@
 #if HAVE_SYS_SOCKET_H
 #include <sys/socket.h>
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+#include <poll.h>
+#endif
 #endif
 
 #ifdef __EMX__
@@ -93,6 +96,8 @@ CLIENT_STATE::CLIENT_STATE()
 #endif
     time_stats.init();
     client_state_dirty = false;
+    state_journal_dirty = false;
+    journal_active_task_set = false;
     old_major_version = 0;
     old_minor_version = 0;
     old_release = 0;
@@ -933,6 +938,79 @@ int CLIENT_STATE::init() {
     return 0;
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+
+// Spend x seconds either doing I/O (if possible) or sleeping.
+//
+// Linux version: curl's sockets and the GUI RPC sockets are kept in
+// epoll sets (see http_curl.cpp and gui_rpc_server.cpp),
+// so a wakeup costs O(ready sockets) rather than O(max fd),
+// and there's no FD_SETSIZE limit.
+// We wait for either set to become readable.
+//
+void CLIENT_STATE::do_io_or_sleep(double max_time) {
+    struct pollfd fds[2];
+    int n, nfds;
+    set_now();
+    double end_time = now + max_time;
+    double time_remaining = max_time;
+
+    while (1) {
+        nfds = 0;
+        fds[nfds].fd = http_ops->get_epoll_fd();
+        fds[nfds].events = POLLIN;
+        nfds++;
+        bool check_gui_rpcs = !autologin_in_progress
+            && gui_rpcs.get_epoll_fd() >= 0;
+        if (check_gui_rpcs) {
+            fds[nfds].fd = gui_rpcs.get_epoll_fd();
+            fds[nfds].events = POLLIN;
+            nfds++;
+        }
+
+        bool have_async = have_async_file_op();
+
+        // prioritize network (including GUI RPC) over async file ops.
+        // if there's a pending asynch file op, poll with zero timeout;
+        // otherwise wait for the remaining amount of time,
+        // or until curl's timer expires.
+        //
+        double timeout = have_async?0:time_remaining;
+        double curl_timeout = http_ops->get_timeout();
+        bool curl_timer = false;
+        if (curl_timeout >= 0 && curl_timeout < timeout) {
+            timeout = curl_timeout;
+            curl_timer = true;
+        }
+        client_thread_mutex.unlock();
+        n = ::poll(fds, nfds, (int)ceil(timeout*1000));
+        client_thread_mutex.lock();
+
+        http_ops->got_events();
+        if (check_gui_rpcs) {
+            gui_rpcs.got_events();
+        }
+
+        if (have_async) {
+            // do the async file op only if no network activity
+            //
+            if (n == 0) {
+                do_async_file_op();
+            }
+        } else {
+            if (n == 0 && !curl_timer) {
+                break;
+            }
+        }
+
+        set_now();
+        if (now > end_time) break;
+        time_remaining = end_time - now;
+    }
+}
+
+#else
+
 static void double_to_timeval(double x, timeval& t) {
     t.tv_sec = (int)x;
     t.tv_usec = (int)(1000000*(x - (int)x));
@@ -1008,6 +1086,8 @@ void CLIENT_STATE::do_io_or_sleep(double max_time) {
     }
 }
 
+#endif
+
 #define POLL_ACTION(name, func) \
     do { if (func()) { \
             ++actions; \
@@ -1344,17 +1424,11 @@ APP* CLIENT_STATE::lookup_app(PROJECT* p, const char* name) {
 }
 
 RESULT* CLIENT_STATE::lookup_result(PROJECT* p, const char* name) {
-    for (RESULT* rp: results) {
-        if (rp->project == p && !strcmp(name, rp->name)) return rp;
-    }
-    return 0;
+    return result_index.lookup(p, name);
 }
 
 WORKUNIT* CLIENT_STATE::lookup_workunit(PROJECT* p, const char* name) {
-    for (WORKUNIT* wup: workunits) {
-        if (wup->project == p && !strcmp(name, wup->name)) return wup;
-    }
-    return 0;
+    return workunit_index.lookup(p, name);
 }
 
 APP_VERSION* CLIENT_STATE::lookup_app_version(
@@ -1371,12 +1445,25 @@ APP_VERSION* CLIENT_STATE::lookup_app_version(
 }
 
 FILE_INFO* CLIENT_STATE::lookup_file_info(PROJECT* p, const char* name) {
-    for (FILE_INFO* fip: file_infos) {
-        if (fip->project == p && !strcmp(fip->name, name)) {
-            return fip;
-        }
-    }
-    return 0;
+    return file_info_index.lookup(p, name);
+}
+
+// add objects to the vectors and indexes.
+// The project must be set (e.g. by link_*()).
+//
+void CLIENT_STATE::add_file_info(FILE_INFO* fip) {
+    file_infos.push_back(fip);
+    file_info_index.add(fip);
+}
+
+void CLIENT_STATE::add_workunit(WORKUNIT* wup) {
+    workunits.push_back(wup);
+    workunit_index.add(wup);
+}
+
+void CLIENT_STATE::add_result(RESULT* rp) {
+    results.push_back(rp);
+    result_index.add(rp);
 }
 
 // functions to create links between state objects
@@ -1710,6 +1797,7 @@ bool CLIENT_STATE::garbage_collect_always() {
                     );
                 }
                 add_old_result(*rp);
+                result_index.remove(rp);
                 delete rp;
                 result_iter = results.erase(result_iter);
                 action = true;
@@ -1787,6 +1875,7 @@ bool CLIENT_STATE::garbage_collect_always() {
                     wup->name
                 );
             }
+            workunit_index.remove(wup);
             delete wup;
             wu_iter = workunits.erase(wu_iter);
             action = true;
@@ -1881,6 +1970,7 @@ bool CLIENT_STATE::garbage_collect_always() {
                     fip->name
                 );
             }
+            file_info_index.remove(fip);
             delete fip;
             fi_iter = file_infos.erase(fi_iter);
             action = true;
@@ -2246,6 +2336,7 @@ int CLIENT_STATE::detach_project(PROJECT* project) {
         fip = *fi_iter;
         if (fip->project == project) {
             fi_iter = file_infos.erase(fi_iter);
+            file_info_index.remove(fip);
             delete fip;
         } else {
             ++fi_iter;
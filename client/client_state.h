@@ -49,9 +49,11 @@ using std::vector;
 #include "hostinfo.h"
 #include "miofile.h"
 #include "net_stats.h"
+#include "obj_index.h"
 #include "pers_file_xfer.h"
 #include "prefs.h"
 #include "scheduler_op.h"
+#include "state_journal.h"
 #include "time_stats.h"
 
 #ifdef SIM
@@ -77,6 +79,12 @@ struct CLIENT_STATE {
     vector<WORKUNIT*> workunits;
     vector<RESULT*> results;
         // list of jobs, ordered by increasing arrival time
+    OBJ_INDEX<FILE_INFO> file_info_index;
+    OBJ_INDEX<WORKUNIT> workunit_index;
+    OBJ_INDEX<RESULT> result_index;
+        // indexes of the above by project and name.
+        // Add objects with add_file_info() etc.,
+        // and remove them from the index when removing from the vector.
 
     PERS_FILE_XFER_SET* pers_file_xfers;
     HTTP_OP_SET* http_ops;
@@ -276,6 +284,9 @@ struct CLIENT_STATE {
     FILE_INFO* lookup_file_info(PROJECT*, const char* name);
     RESULT* lookup_result(PROJECT*, const char*);
     WORKUNIT* lookup_workunit(PROJECT*, const char*);
+    void add_file_info(FILE_INFO*);
+    void add_workunit(WORKUNIT*);
+    void add_result(RESULT*);
     APP_VERSION* lookup_app_version(
         APP*, char* platform, int ver, char* plan_class
     );
@@ -478,6 +489,19 @@ struct CLIENT_STATE {
     int write_state(MIOFILE&);
     int write_state_file();
     int write_state_file_if_needed();
+    STATE_JOURNAL state_journal;
+    bool state_journal_dirty;
+        // some objects need to be written to the journal
+    bool journal_active_task_set;
+    void journal_result(RESULT*);
+    void journal_file_info(FILE_INFO*);
+    void journal_project(PROJECT*);
+    void journal_active_tasks();
+        // the above note a change to be written to the journal,
+        // rather than rewriting the state file
+    int write_state_journal();
+    void replay_state_journal();
+    int replay_journal_record(XML_PARSER&);
     void check_anonymous();
     int parse_app_info(PROJECT*, FILE*);
     int write_state_gui(MIOFILE&);
@@ -217,10 +217,11 @@ FILE_INFO::FILE_INFO() {
     project = NULL;
     download_urls.clear();
     upload_urls.clear();
-    safe_strcpy(xml_signature, "");
-    safe_strcpy(file_signature, "");
+    xml_signature.clear();
+    file_signature.clear();
     cert_sigs = 0;
     async_verify = NULL;
+    journal_pending = false;
 }
 
 FILE_INFO::~FILE_INFO() {
@@ -322,8 +323,7 @@ int FILE_INFO::parse(XML_PARSER& xp) {
             retval = copy_element_contents(
                 xp.f->f,
                 "</xml_signature>",
-                xml_signature,
-                sizeof(xml_signature)
+                xml_signature
             );
             if (retval) return retval;
             strip_whitespace(xml_signature);
@@ -333,8 +333,7 @@ int FILE_INFO::parse(XML_PARSER& xp) {
             retval = copy_element_contents(
                 xp.f->f,
                 "</file_signature>",
-                file_signature,
-                sizeof(file_signature)
+                file_signature
             );
             if (retval) return retval;
             strip_whitespace(file_signature);
@@ -470,7 +469,7 @@ int FILE_INFO::write(MIOFILE& out, bool to_server) {
         }
         if (signature_required) out.printf("    <signature_required/>\n");
         if (is_user_file) out.printf("    <is_user_file/>\n");
-        if (strlen(file_signature)) out.printf("    <file_signature>\n%s\n</file_signature>\n", file_signature);
+        if (file_signature.size()) out.printf("    <file_signature>\n%s\n</file_signature>\n", file_signature.c_str());
     }
     if (sticky_expire_time) {
         out.printf("    <sticky_expire_time>%f</sticky_expire_time>\n",
@@ -490,10 +489,10 @@ int FILE_INFO::write(MIOFILE& out, bool to_server) {
         if (retval) return retval;
     }
     if (!to_server) {
-        if (strlen(xml_signature)) {
+        if (xml_signature.size()) {
             out.printf(
                 "    <xml_signature>\n%s    </xml_signature>\n",
-                xml_signature
+                xml_signature.c_str()
             );
         }
     }
@@ -623,11 +622,11 @@ int FILE_INFO::merge_info(FILE_INFO& new_info) {
 
     // replace signatures
     //
-    if (strlen(new_info.file_signature)) {
-        safe_strcpy(file_signature, new_info.file_signature);
+    if (new_info.file_signature.size()) {
+        file_signature = new_info.file_signature;
     }
-    if (strlen(new_info.xml_signature)) {
-        safe_strcpy(xml_signature, new_info.xml_signature);
+    if (new_info.xml_signature.size()) {
+        xml_signature = new_info.xml_signature;
     }
 
     // If the file is supposed to be executable and is PRESENT,
@@ -132,15 +132,19 @@ struct FILE_INFO {
     URL_LIST upload_urls;
     bool download_gzipped;
         // if set, download NAME.gz and gunzip it to NAME
-    char xml_signature[MAX_SIGNATURE_LEN];
+    std::string xml_signature;
         // the upload signature
-    char file_signature[MAX_SIGNATURE_LEN];
+    std::string file_signature;
         // if the file itself is signed (for executable files)
-        // this is the signature
+        // this is the signature.
+        // These are strings, not fixed buffers;
+        // most files have neither, and a host may have 100K files
     std::string error_msg;
         // if permanent error occurs during file xfer, it's recorded here
     CERT_SIGS* cert_sigs;
     ASYNC_VERIFY* async_verify;
+    bool journal_pending;
+        // write to state file journal; see CLIENT_STATE::journal_file_info()
 
     FILE_INFO();
     ~FILE_INFO();
@@ -1740,7 +1740,7 @@ bool CLIENT_STATE::enforce_run_list(vector<RESULT*>& run_list) {
 
     }
     if (action) {
-        set_client_state_dirty("enforce_cpu_schedule");
+        journal_active_tasks();
     }
     if (log_flags.cpu_sched_debug) {
         msg_printf(0, MSG_INFO, "[cpu_sched_debug] enforce_run_list: end");
@@ -77,9 +77,10 @@ bool CLIENT_STATE::handle_finished_apps() {
             if (!action) {
                 adjust_rec();     // update REC before erasing ACTIVE_TASK
             }
+            journal_project(atp->result->project);
             iter = active_tasks.active_tasks.erase(iter);
             delete atp;
-            set_client_state_dirty("handle_finished_apps");
+            journal_active_tasks();
 
             // the following is critical; otherwise the result is
             // still in the "scheduled" list and enforce_schedule()
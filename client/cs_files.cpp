@@ -257,7 +257,7 @@ int FILE_INFO::verify_file(
     if (!verify_contents) return 0;
 
     if (signature_required) {
-        if (!strlen(file_signature) && !cert_sigs) {
+        if (file_signature.empty() && !cert_sigs) {
             msg_printf(project, MSG_INTERNAL_ERROR,
                 "Application file %s missing signature", name
             );
@@ -465,6 +465,7 @@ bool CLIENT_STATE::create_and_delete_pers_file_xfers() {
             }
             iter = pers_file_xfers->pers_file_xfers.erase(iter);
             delete pfx;
+            journal_file_info(fip);
             action = true;
             // `delete pfx' should have set pfx->fip->pfx to NULL
             assert (fip == NULL || fip->pers_file_xfer == NULL);
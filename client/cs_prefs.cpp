@@ -597,7 +597,7 @@ int PROJECT::parse_preferences_for_user_files() {
             fip->download_urls.add(url);
             safe_strcpy(fip->name, filename.c_str());
             fip->is_user_file = true;
-            gstate.file_infos.push_back(fip);
+            gstate.add_file_info(fip);
         }
 
         fr.file_info = fip;
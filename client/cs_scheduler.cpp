@@ -889,7 +889,7 @@ int CLIENT_STATE::handle_scheduler_reply(
                 );
                 delete fip;
             } else {
-                file_infos.push_back(fip);
+                add_file_info(fip);
             }
         }
     }
@@ -978,7 +978,7 @@ int CLIENT_STATE::handle_scheduler_reply(
             continue;
         }
         wup->clear_errors();
-        workunits.push_back(wup);
+        add_workunit(wup);
     }
     double est_rsc_runtime[MAX_RSC];
     bool got_work_for_rsc[MAX_RSC];
@@ -1047,7 +1047,7 @@ int CLIENT_STATE::handle_scheduler_reply(
         rp->wup->version_num = rp->version_num;
         rp->received_time = now;
         new_results.push_back(rp);
-        results.push_back(rp);
+        add_result(rp);
     }
 
     // find the resources for which we requested work and didn't get any
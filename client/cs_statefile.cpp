@@ -52,6 +52,36 @@ void CLIENT_STATE::set_client_state_dirty(const char* source) {
     client_state_dirty = true;
 }
 
+// The following note changes to be written to the state file journal
+// (see state_journal.h).
+// Use them instead of set_client_state_dirty()
+// for frequent changes that involve only these objects.
+//
+// A job's output files change along with it, so write those too.
+//
+void CLIENT_STATE::journal_result(RESULT* rp) {
+    rp->journal_pending = true;
+    for (FILE_REF& fref: rp->output_files) {
+        if (fref.file_info) fref.file_info->journal_pending = true;
+    }
+    state_journal_dirty = true;
+}
+
+void CLIENT_STATE::journal_file_info(FILE_INFO* fip) {
+    fip->journal_pending = true;
+    state_journal_dirty = true;
+}
+
+void CLIENT_STATE::journal_project(PROJECT* p) {
+    p->journal_pending = true;
+    state_journal_dirty = true;
+}
+
+void CLIENT_STATE::journal_active_tasks() {
+    journal_active_task_set = true;
+    state_journal_dirty = true;
+}
+
 static bool valid_state_file(const char* fname) {
     char buf[256];
     FILE* f = boinc_fopen(fname, "r");
@@ -108,7 +138,13 @@ int CLIENT_STATE::parse_state_file() {
         msg_printf(0, MSG_INFO, "Creating new client state file");
         return ERR_FOPEN;
     }
-    return parse_state_file_aux(fname);
+    int retval = parse_state_file_aux(fname);
+#ifndef SIM
+    if (!retval) {
+        replay_state_journal();
+    }
+#endif
+    return retval;
 }
 
 int CLIENT_STATE::parse_state_file_aux(const char* fname) {
@@ -216,7 +252,7 @@ int CLIENT_STATE::parse_state_file_aux(const char* fname) {
                 delete fip;
                 continue;
             }
-            file_infos.push_back(fip);
+            add_file_info(fip);
 #ifndef SIM
             // If the file had a failure before,
             // don't start another file transfer
@@ -338,7 +374,7 @@ int CLIENT_STATE::parse_state_file_aux(const char* fname) {
                 delete wup;
                 continue;
             }
-            workunits.push_back(wup);
+            add_workunit(wup);
             continue;
         }
         if (xp.match_tag("result")) {
@@ -393,7 +429,7 @@ int CLIENT_STATE::parse_state_file_aux(const char* fname) {
                 continue;
             }
             rp->wup->version_num = rp->version_num;
-            results.push_back(rp);
+            add_result(rp);
             continue;
         }
         if (xp.match_tag("project_files")) {
@@ -453,6 +489,9 @@ int CLIENT_STATE::parse_state_file_aux(const char* fname) {
         if (xp.parse_string("platform_name", statefile_platform_name)) {
             continue;
         }
+        if (xp.parse_int("state_journal_seqno", state_journal.seqno)) {
+            continue;
+        }
         if (xp.parse_string("alt_platform", stemp)) {
             continue;
         }
@@ -725,6 +764,23 @@ int CLIENT_STATE::write_state_file() {
         if (attempt < MAX_STATE_FILE_WRITE_ATTEMPTS) continue;
         return ERR_RENAME;
     }
+
+    // the new state file has everything; start a new journal
+    //
+    double nbytes = 0;
+    file_size(STATE_FILE_NAME, nbytes);
+    state_journal.state_file_written(nbytes, now);
+    state_journal_dirty = false;
+    journal_active_task_set = false;
+    for (PROJECT* p: projects) {
+        p->journal_pending = false;
+    }
+    for (FILE_INFO* fip: file_infos) {
+        fip->journal_pending = false;
+    }
+    for (RESULT* rp: results) {
+        rp->journal_pending = false;
+    }
     return 0;
 }
 
@@ -791,7 +847,8 @@ int CLIENT_STATE::write_state(MIOFILE& f) {
         "<user_gpu_prev_request>%d</user_gpu_prev_request>\n"
         "<user_network_request>%d</user_network_request>\n"
         "<new_version_check_time>%f</new_version_check_time>\n"
-        "<all_projects_list_check_time>%f</all_projects_list_check_time>\n",
+        "<all_projects_list_check_time>%f</all_projects_list_check_time>\n"
+        "<state_journal_seqno>%d</state_journal_seqno>\n",
         get_primary_platform(),
         core_client_version.major,
         core_client_version.minor,
@@ -802,7 +859,8 @@ int CLIENT_STATE::write_state(MIOFILE& f) {
         gpu_run_mode.get_prev(),
         network_run_mode.get_perm(),
         new_version_check_time,
-        all_projects_list_check_time
+        all_projects_list_check_time,
+        state_journal.seqno + 1
     );
     if (strlen(language)) {
         f.printf("<language>%s</language>\n", language);
@@ -833,17 +891,190 @@ int CLIENT_STATE::write_state(MIOFILE& f) {
     return 0;
 }
 
-// Write the client_state.xml file if necessary
+// Write the client_state.xml file if necessary.
+// If only journaled objects have changed, append them to the journal.
 // TODO: write no more often than X seconds
 //
 int CLIENT_STATE::write_state_file_if_needed() {
     int retval;
-    if (client_state_dirty) {
-        client_state_dirty = false;
-        retval = write_state_file();
-        if (retval) return retval;
+    if (!client_state_dirty && !state_journal.need_compaction(now)) {
+        if (!state_journal_dirty) return 0;
+        retval = write_state_journal();
+        if (!retval) return 0;
+        msg_printf(NULL, MSG_INTERNAL_ERROR,
+            "Couldn't write state file journal: %s", boincerror(retval)
+        );
     }
-    return 0;
+    client_state_dirty = false;
+    return write_state_file();
+}
+
+// Append journal records for objects with journal_pending set,
+// and for the active task set if it changed.
+// Each record is
+// <journal_record>
+//    [ <project_url>...</project_url> ]
+//    <project>, <file>, <result> or <active_task_set> element
+// </journal_record>
+//
+int CLIENT_STATE::write_state_journal() {
+    MFILE mf;
+    MIOFILE f;
+    int retval, n = 0;
+
+    retval = state_journal.open(mf);
+    if (retval) return retval;
+    f.init_mfile(&mf);
+    state_journal_dirty = false;
+    for (PROJECT* p: projects) {
+        if (!p->journal_pending) continue;
+        p->journal_pending = false;
+        if (p->app_test) continue;
+        f.printf("<journal_record>\n");
+        p->write_state(f);
+        f.printf("</journal_record>\n");
+        n++;
+    }
+    for (FILE_INFO* fip: file_infos) {
+        if (!fip->journal_pending) continue;
+        fip->journal_pending = false;
+        if (fip->project->app_test) continue;
+        if (fip->anonymous_platform_file) continue;
+        f.printf(
+            "<journal_record>\n"
+            "<project_url>%s</project_url>\n",
+            fip->project->master_url
+        );
+        fip->write(f, false);
+        f.printf("</journal_record>\n");
+        n++;
+    }
+    for (RESULT* rp: results) {
+        if (!rp->journal_pending) continue;
+        rp->journal_pending = false;
+        if (rp->project->app_test) continue;
+        f.printf(
+            "<journal_record>\n"
+            "<project_url>%s</project_url>\n",
+            rp->project->master_url
+        );
+        rp->write(f, false);
+        f.printf("</journal_record>\n");
+        n++;
+    }
+    if (journal_active_task_set) {
+        journal_active_task_set = false;
+        f.printf("<journal_record>\n");
+        active_tasks.write(f);
+        f.printf("</journal_record>\n");
+        n++;
+    }
+    retval = state_journal.close(mf);
+    if (log_flags.statefile_debug) {
+        msg_printf(0, MSG_INFO,
+            "[statefile] Wrote %d journal records; journal size %.0f",
+            n, state_journal.size
+        );
+    }
+    return retval;
+}
+
+// Apply journal records to the state we just parsed.
+// Stop at the first bad record;
+// it's probably the end of a partial write.
+//
+void CLIENT_STATE::replay_state_journal() {
+    int n = 0;
+
+    FILE* f = state_journal.open_for_replay();
+    if (!f) return;
+    MIOFILE mf;
+    XML_PARSER xp(&mf);
+    mf.init_file(f);
+    while (!xp.get_tag()) {
+        if (!xp.match_tag("journal_record")) break;
+        if (replay_journal_record(xp)) break;
+        n++;
+    }
+    fclose(f);
+    if (n) {
+        msg_printf(NULL, MSG_INFO, "Applied %d state file journal records", n);
+    }
+}
+
+// Objects that no longer exist (e.g. garbage-collected results) are skipped.
+//
+int CLIENT_STATE::replay_journal_record(XML_PARSER& xp) {
+    PROJECT* project = NULL;
+    char buf[256];
+    int retval;
+
+    while (!xp.get_tag()) {
+        if (xp.match_tag("/journal_record")) return 0;
+        if (xp.parse_str("project_url", buf, sizeof(buf))) {
+            project = lookup_project(buf);
+            continue;
+        }
+        if (xp.match_tag("project")) {
+            PROJECT temp_project;
+            retval = temp_project.parse_state(xp);
+            if (retval) return retval;
+            PROJECT* p = lookup_project(temp_project.master_url);
+            if (p) {
+                p->copy_state_fields(temp_project);
+            }
+            continue;
+        }
+        if (xp.match_tag("file")) {
+            FILE_INFO temp_fi;
+            retval = temp_fi.parse(xp);
+            bool xfer_pending = (temp_fi.pers_file_xfer != NULL);
+            if (xfer_pending) {
+                delete temp_fi.pers_file_xfer;
+                temp_fi.pers_file_xfer = NULL;
+            }
+            if (retval) return retval;
+            FILE_INFO* fip = project?lookup_file_info(project, temp_fi.name):NULL;
+            if (fip) {
+                fip->status = temp_fi.status;
+                fip->uploaded = temp_fi.uploaded;
+                fip->nbytes = temp_fi.nbytes;
+                safe_strcpy(fip->md5_cksum, temp_fi.md5_cksum);
+                fip->error_msg = temp_fi.error_msg;
+
+                // if the transfer finished, don't start it again
+                //
+                if (fip->pers_file_xfer && !xfer_pending) {
+                    PERS_FILE_XFER* pfx = fip->pers_file_xfer;
+                    pers_file_xfers->remove(pfx);
+                    delete pfx;
+                }
+            }
+            continue;
+        }
+        if (xp.match_tag("result")) {
+            RESULT temp_result;
+            retval = temp_result.parse_state(xp);
+            if (retval) return retval;
+            RESULT* rp = project?lookup_result(project, temp_result.name):NULL;
+            if (rp) {
+                rp->copy_state_fields(temp_result);
+            }
+            continue;
+        }
+        if (xp.match_tag("active_task_set")) {
+            // parse into the emptied task list;
+            // ACTIVE_TASK::parse() rejects a task whose slot is in use
+            //
+            retval = replace_list(active_tasks.active_tasks,
+                [&]() {return active_tasks.parse(xp);}
+            );
+            if (retval) return retval;
+            continue;
+        }
+        return ERR_XML_PARSE;
+    }
+    return ERR_XML_PARSE;
 }
 
 #endif // ifndef SIM
@@ -927,7 +1158,7 @@ int CLIENT_STATE::parse_app_info(PROJECT* p, FILE* in) {
             fip->nbytes = size;
             fip->status = FILE_PRESENT;
             fip->anonymous_platform_file = true;
-            file_infos.push_back(fip);
+            add_file_info(fip);
             continue;
         }
         if (xp.match_tag("app")) {
@@ -149,7 +149,7 @@ int FILE_XFER::init_upload(FILE_INFO& file_info) {
             "<data>\n",
             BOINC_MAJOR_VERSION, BOINC_MINOR_VERSION, BOINC_RELEASE,
             file_info.name,
-            file_info.xml_signature,
+            file_info.xml_signature.c_str(),
             file_info.max_nbytes,
             file_info.nbytes,
             file_info.md5_cksum,
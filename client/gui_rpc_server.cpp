@@ -37,6 +37,7 @@
 #include <sys/stat.h>
 #endif
 #include <sys/un.h>
+#include <algorithm>
 #include <vector>
 #include <cstring>
 #if HAVE_NETINET_IN_H
@@ -51,6 +52,9 @@
 #if HAVE_FCNTL_H
 #include <fcntl.h>
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 #endif
 
 #include "error_numbers.h"
@@ -102,6 +106,9 @@ GUI_RPC_CONN_SET::GUI_RPC_CONN_SET() {
     lsock = -1;
     time_of_last_rpc_needing_network = 0;
     safe_strcpy(password,"");
+#ifdef HAVE_SYS_EPOLL_H
+    epoll_fd = -1;
+#endif
 }
 
 bool GUI_RPC_CONN_SET::poll() {
@@ -233,9 +240,56 @@ int GUI_RPC_CONN_SET::get_allowed_hosts() {
 
 int GUI_RPC_CONN_SET::insert(GUI_RPC_CONN* p) {
     gui_rpcs.push_back(p);
+#ifdef HAVE_SYS_EPOLL_H
+    epoll_add(p->sock, p);
+#endif
     return 0;
 }
 
+// close a connection and remove it from the set
+//
+void GUI_RPC_CONN_SET::remove(GUI_RPC_CONN* gr) {
+    vector<GUI_RPC_CONN*>::iterator iter =
+        std::find(gui_rpcs.begin(), gui_rpcs.end(), gr);
+    if (iter != gui_rpcs.end()) {
+        gui_rpcs.erase(iter);
+    }
+#ifdef HAVE_SYS_EPOLL_H
+    // do this explicitly; a closed socket stays in the epoll set
+    // if a child process (forked but not yet exec'd) has a copy
+    //
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, gr->sock, NULL);
+#endif
+    delete gr;
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+// register a socket for input;
+// gr is NULL for the listening socket
+//
+void GUI_RPC_CONN_SET::epoll_add(int sock, GUI_RPC_CONN* gr) {
+    struct epoll_event ev;
+
+    if (epoll_fd < 0) {
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd < 0) {
+            msg_printf(NULL, MSG_INTERNAL_ERROR,
+                "epoll_create1() failed: %s", strerror(errno)
+            );
+            return;
+        }
+    }
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = gr;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sock, &ev)) {
+        msg_printf(NULL, MSG_INTERNAL_ERROR,
+            "Can't register GUI RPC socket %d: %s", sock, strerror(errno)
+        );
+    }
+}
+#endif
+
 int GUI_RPC_CONN_SET::init_unix_domain() {
 #if !defined(_WIN32)
     struct sockaddr_un addr;
@@ -280,6 +334,9 @@ int GUI_RPC_CONN_SET::init_unix_domain() {
         boinc_close_socket(lsock);
         return ERR_LISTEN;
     }
+#ifdef HAVE_SYS_EPOLL_H
+    epoll_add(lsock, NULL);
+#endif
 #endif
     return 0;
 }
@@ -368,6 +425,9 @@ int GUI_RPC_CONN_SET::init_tcp(bool last_time) {
         lsock = -1;
         return ERR_LISTEN;
     }
+#ifdef HAVE_SYS_EPOLL_H
+    epoll_add(lsock, NULL);
+#endif
     return 0;
 }
 
@@ -414,6 +474,7 @@ static void show_connect_error(sockaddr_storage& s) {
     count = 0;
 }
 
+#ifndef HAVE_SYS_EPOLL_H
 void GUI_RPC_CONN_SET::get_fdset(FDSET_GROUP& fg, FDSET_GROUP& all) {
     unsigned int i;
     GUI_RPC_CONN* gr;
@@ -435,6 +496,7 @@ void GUI_RPC_CONN_SET::get_fdset(FDSET_GROUP& fg, FDSET_GROUP& all) {
     FD_SET(lsock, &all.read_fds);
     if (lsock > all.max_fd) all.max_fd = lsock;
 }
+#endif
 
 bool GUI_RPC_CONN_SET::check_allowed_list(sockaddr_storage& peer_ip) {
     vector<sockaddr_storage>::iterator remote_iter = allowed_remote_ip_addresses.begin();
@@ -447,19 +509,64 @@ bool GUI_RPC_CONN_SET::check_allowed_list(sockaddr_storage& peer_ip) {
     return false;
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+void GUI_RPC_CONN_SET::got_events() {
+    struct epoll_event events[64];
+    bool new_conn = false;
+    vector<GUI_RPC_CONN*> failed, readable;
+    GUI_RPC_CONN* gr;
+
+    if (lsock < 0 || epoll_fd < 0) return;
+    int n = epoll_wait(epoll_fd, events, 64, 0);
+    for (int i=0; i<n; i++) {
+        gr = (GUI_RPC_CONN*)events[i].data.ptr;
+        if (!gr) {
+            new_conn = true;
+        } else if (events[i].events & (EPOLLERR|EPOLLHUP)) {
+            failed.push_back(gr);
+        } else if (events[i].events & EPOLLIN) {
+            readable.push_back(gr);
+        }
+    }
+    handle_sockets(new_conn, failed, readable);
+}
+#else
 void GUI_RPC_CONN_SET::got_select(FDSET_GROUP& fg) {
-    int sock, retval;
-    vector<GUI_RPC_CONN*>::iterator iter;
+    vector<GUI_RPC_CONN*> failed, readable;
     GUI_RPC_CONN* gr;
 
     if (lsock < 0) return;
+    for (unsigned int i=0; i<gui_rpcs.size(); i++) {
+        gr = gui_rpcs[i];
+        if (FD_ISSET(gr->sock, &fg.exc_fds)) {
+            failed.push_back(gr);
+        } else if (FD_ISSET(gr->sock, &fg.read_fds)) {
+            readable.push_back(gr);
+        }
+    }
+    handle_sockets(FD_ISSET(lsock, &fg.read_fds), failed, readable);
+}
+#endif
+
+// accept a new connection if there is one,
+// and handle connections that are readable or failed.
+// Only these are looked at, so the cost doesn't grow
+// with the number of idle connections.
+//
+void GUI_RPC_CONN_SET::handle_sockets(
+    bool new_conn, vector<GUI_RPC_CONN*>& failed,
+    vector<GUI_RPC_CONN*>& readable
+) {
+    int sock, retval;
+    unsigned int i;
+    GUI_RPC_CONN* gr;
 
     // new connection on our listening socket?
     //
-    if (FD_ISSET(lsock, &fg.read_fds)) {
+    if (new_conn) {
         struct sockaddr_storage addr;
 
-        // For unknown reasons, the FD_ISSET() above succeeds
+        // For unknown reasons, the listening socket is reported readable
         // after a SIGTERM, SIGHUP, SIGINT or SIGQUIT is received,
         // even if there is no data available on the socket.
         // This causes the accept() call to block, preventing the main
@@ -533,42 +640,30 @@ void GUI_RPC_CONN_SET::got_select(FDSET_GROUP& fg) {
 
     // delete connections with failed sockets
     //
-    iter = gui_rpcs.begin();
-    while (iter != gui_rpcs.end()) {
-        gr = *iter;
-        if (FD_ISSET(gr->sock, &fg.exc_fds)) {
-            if (log_flags.gui_rpc_debug) {
-                msg_printf(0, MSG_INFO,
-                    "[gui_rpc] GUI RPC connection failed: sock %d", gr->sock
-                );
-            }
-            delete gr;
-            iter = gui_rpcs.erase(iter);
-            continue;
+    for (i=0; i<failed.size(); i++) {
+        gr = failed[i];
+        if (log_flags.gui_rpc_debug) {
+            msg_printf(0, MSG_INFO,
+                "[gui_rpc] GUI RPC connection failed: sock %d", gr->sock
+            );
         }
-        ++iter;
+        remove(gr);
     }
 
     // handle RPCs on connections with pending requests
     //
-    iter = gui_rpcs.begin();
-    while (iter != gui_rpcs.end()) {
-        gr = *iter;
-        if (FD_ISSET(gr->sock, &fg.read_fds)) {
-            retval = gr->handle_rpc();
-            if (retval) {
-                if (log_flags.gui_rpc_debug) {
-                    msg_printf(NULL, MSG_INFO,
-                        "[gui_rpc] handler returned %d, closing socket %d\n",
-                        retval, gr->sock
-                    );
-                }
-                delete gr;
-                iter = gui_rpcs.erase(iter);
-                continue;
+    for (i=0; i<readable.size(); i++) {
+        gr = readable[i];
+        retval = gr->handle_rpc();
+        if (retval) {
+            if (log_flags.gui_rpc_debug) {
+                msg_printf(NULL, MSG_INFO,
+                    "[gui_rpc] handler returned %d, closing socket %d\n",
+                    retval, gr->sock
+                );
             }
+            remove(gr);
         }
-        ++iter;
     }
 }
 
@@ -583,6 +678,12 @@ void GUI_RPC_CONN_SET::close() {
         delete gui_rpcs[i];
     }
     gui_rpcs.clear();
+#ifdef HAVE_SYS_EPOLL_H
+    if (epoll_fd >= 0) {
+        ::close(epoll_fd);
+        epoll_fd = -1;
+    }
+#endif
 }
 
 void* gui_rpc_handler(void* p) {
@@ -102,8 +102,19 @@ class GUI_RPC_CONN_SET {
     int get_allowed_hosts();
     void get_password();
     int insert(GUI_RPC_CONN*);
+    void remove(GUI_RPC_CONN*);
     bool check_allowed_list(sockaddr_storage& ip_addr);
     bool remote_hosts_configured;
+    void handle_sockets(
+        bool new_conn, std::vector<GUI_RPC_CONN*>& failed,
+        std::vector<GUI_RPC_CONN*>& readable
+    );
+#ifdef HAVE_SYS_EPOLL_H
+    int epoll_fd;
+        // the listening socket and connections stay registered here
+        // while they exist, rather than being added on each wakeup
+    void epoll_add(int sock, GUI_RPC_CONN*);
+#endif
 public:
     int lsock;
     double time_of_last_rpc_needing_network;
@@ -111,8 +122,15 @@ public:
 
     GUI_RPC_CONN_SET();
     char password[256];
+#ifdef HAVE_SYS_EPOLL_H
+    int get_epoll_fd() {
+        return epoll_fd;
+    }
+    void got_events();
+#else
     void get_fdset(FDSET_GROUP&, FDSET_GROUP&);
     void got_select(FDSET_GROUP&);
+#endif
     int init_tcp(bool last_time);
     int init_unix_domain();
     void close();
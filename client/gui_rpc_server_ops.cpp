@@ -218,7 +218,7 @@ static void handle_project_reset(GUI_RPC_CONN& grc) {
 static void handle_project_suspend(GUI_RPC_CONN& grc) {
     PROJECT* p = get_project_parse(grc);
     if (!p) return;
-    gstate.set_client_state_dirty("Project modified by user");
+    gstate.journal_project(p);
     msg_printf(p, MSG_INFO, "project suspended by user");
     p->suspend();
     grc.mfout.printf("<success/>\n");
@@ -227,7 +227,7 @@ static void handle_project_suspend(GUI_RPC_CONN& grc) {
 static void handle_project_resume(GUI_RPC_CONN& grc) {
     PROJECT* p = get_project_parse(grc);
     if (!p) return;
-    gstate.set_client_state_dirty("Project modified by user");
+    gstate.journal_project(p);
     msg_printf(p, MSG_INFO, "project resumed by user");
     p->resume();
     grc.mfout.printf("<success/>\n");
@@ -253,7 +253,7 @@ static void handle_project_detach(GUI_RPC_CONN& grc) {
 static void handle_project_update(GUI_RPC_CONN& grc) {
     PROJECT* p = get_project_parse(grc);
     if (!p) return;
-    gstate.set_client_state_dirty("Project modified by user");
+    gstate.journal_project(p);
     msg_printf(p, MSG_INFO, "update requested by user");
     p->sched_rpc_pending = RPC_REASON_USER_REQ;
     p->min_rpc_time = 0;
@@ -267,7 +267,7 @@ static void handle_project_update(GUI_RPC_CONN& grc) {
 static void handle_project_nomorework(GUI_RPC_CONN& grc) {
     PROJECT* p = get_project_parse(grc);
     if (!p) return;
-    gstate.set_client_state_dirty("Project modified by user");
+    gstate.journal_project(p);
     msg_printf(p, MSG_INFO, "work fetch suspended by user");
     p->dont_request_more_work = true;
     grc.mfout.printf("<success/>\n");
@@ -276,7 +276,7 @@ static void handle_project_nomorework(GUI_RPC_CONN& grc) {
 static void handle_project_allowmorework(GUI_RPC_CONN& grc) {
     PROJECT* p = get_project_parse(grc);
     if (!p) return;
-    gstate.set_client_state_dirty("Project modified by user");
+    gstate.journal_project(p);
     msg_printf(p, MSG_INFO, "work fetch resumed by user");
     p->dont_request_more_work = false;
     gstate.request_work_fetch("project work fetch resumed by user");
@@ -286,7 +286,7 @@ static void handle_project_allowmorework(GUI_RPC_CONN& grc) {
 static void handle_project_detach_when_done(GUI_RPC_CONN& grc) {
     PROJECT* p = get_project_parse(grc);
     if (!p) return;
-    gstate.set_client_state_dirty("Project modified by user");
+    gstate.journal_project(p);
     msg_printf(p, MSG_INFO, "detach when done set by user");
     p->detach_when_done = true;
     p->dont_request_more_work = true;
@@ -296,7 +296,7 @@ static void handle_project_detach_when_done(GUI_RPC_CONN& grc) {
 static void handle_project_dont_detach_when_done(GUI_RPC_CONN& grc) {
     PROJECT* p = get_project_parse(grc);
     if (!p) return;
-    gstate.set_client_state_dirty("Project modified by user");
+    gstate.journal_project(p);
     msg_printf(p, MSG_INFO, "detach when done cleared by user");
     p->detach_when_done = false;
     p->dont_request_more_work = false;
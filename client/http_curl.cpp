@@ -31,6 +31,9 @@
 #if HAVE_SYS_SOCKET_H
 #include <sys/socket.h>
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 #endif
 
 #include "base64.h"
@@ -56,6 +59,12 @@ using std::min;
 using std::vector;
 
 static CURLM* g_curlMulti = NULL;
+#ifdef HAVE_SYS_EPOLL_H
+static int g_curl_epoll_fd = -1;
+static double g_curl_timeout = -1;
+    // when curl wants curl_multi_socket_action(CURL_SOCKET_TIMEOUT);
+    // -1 if never
+#endif
 static char g_user_agent_string[256] = {""};
 static unsigned int g_trace_count = 0;
 static bool got_expectation_failed = false;
@@ -860,18 +869,70 @@ void HTTP_OP::setup_proxy_session(bool no_proxy) {
 //
 fd_set read_fds, write_fds, error_fds;
 
+#ifdef HAVE_SYS_EPOLL_H
+// On Linux we use curl's "multi_socket" interface:
+// curl tells us (through these callbacks) which of its sockets to watch
+// and when it next needs to be called,
+// and we keep the sockets in an epoll set.
+// Unlike select(), the cost of a wakeup doesn't grow with
+// the number of transfers, and there's no FD_SETSIZE limit.
+//
+static int multi_socket_callback(
+    CURL*, curl_socket_t sock, int what, void*, void*
+) {
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.data.fd = sock;
+    if (what == CURL_POLL_REMOVE) {
+        epoll_ctl(g_curl_epoll_fd, EPOLL_CTL_DEL, sock, &ev);
+        return 0;
+    }
+    if (what & CURL_POLL_IN) ev.events |= EPOLLIN;
+    if (what & CURL_POLL_OUT) ev.events |= EPOLLOUT;
+    if (epoll_ctl(g_curl_epoll_fd, EPOLL_CTL_MOD, sock, &ev)) {
+        if (errno == ENOENT) {
+            epoll_ctl(g_curl_epoll_fd, EPOLL_CTL_ADD, sock, &ev);
+        }
+    }
+    return 0;
+}
+
+static int multi_timer_callback(CURLM*, long timeout_ms, void*) {
+    if (timeout_ms < 0) {
+        g_curl_timeout = -1;
+    } else {
+        g_curl_timeout = dtime() + timeout_ms/1000.;
+    }
+    return 0;
+}
+#endif
+
 // call these once at the start of the program and once at the end
 //
 int curl_init() {
     curl_global_init(CURL_GLOBAL_ALL);
     g_curlMulti = curl_multi_init();
-    return (int)(g_curlMulti == NULL);
+    if (!g_curlMulti) return 1;
+#ifdef HAVE_SYS_EPOLL_H
+    g_curl_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (g_curl_epoll_fd < 0) return 1;
+    curl_multi_setopt(g_curlMulti, CURLMOPT_SOCKETFUNCTION, multi_socket_callback);
+    curl_multi_setopt(g_curlMulti, CURLMOPT_TIMERFUNCTION, multi_timer_callback);
+#endif
+    return 0;
 }
 
 int curl_cleanup() {
     if (g_curlMulti) {
         curl_multi_cleanup(g_curlMulti);
     }
+#ifdef HAVE_SYS_EPOLL_H
+    if (g_curl_epoll_fd >= 0) {
+        close(g_curl_epoll_fd);
+        g_curl_epoll_fd = -1;
+    }
+#endif
     curl_global_cleanup();
     return 0;
 }
@@ -908,11 +969,13 @@ void HTTP_OP::close_files() {
     }
 }
 
+#ifndef HAVE_SYS_EPOLL_H
 void HTTP_OP_SET::get_fdset(FDSET_GROUP& fg) {
     curl_multi_fdset(
         g_curlMulti, &fg.read_fds, &fg.write_fds, &fg.exc_fds, &fg.max_fd
     );
 }
+#endif
 
 // we have a message for this HTTP_OP.
 // get the response code for this request
@@ -1058,11 +1121,44 @@ void HTTP_OP::handle_messages(CURLMsg *pcurlMsg) {
     }
 }
 
-void HTTP_OP_SET::got_select(FDSET_GROUP&, double timeout) {
-    int iNumMsg;
-    HTTP_OP* hop = NULL;
-    CURLMsg *pcurlMsg = NULL;
+#ifdef HAVE_SYS_EPOLL_H
+int HTTP_OP_SET::get_epoll_fd() {
+    return g_curl_epoll_fd;
+}
+
+double HTTP_OP_SET::get_timeout() {
+    if (g_curl_timeout < 0) return -1;
+    return std::max(0., g_curl_timeout - dtime());
+}
 
+// tell curl which of its sockets are ready, and whether its timer expired
+//
+void HTTP_OP_SET::got_events() {
+    struct epoll_event events[64];
+    int i, n, mask, iRunning;
+
+    n = epoll_wait(g_curl_epoll_fd, events, 64, 0);
+    for (i=0; i<n; i++) {
+        mask = 0;
+        if (events[i].events & EPOLLIN) mask |= CURL_CSELECT_IN;
+        if (events[i].events & EPOLLOUT) mask |= CURL_CSELECT_OUT;
+        if (events[i].events & (EPOLLERR|EPOLLHUP)) mask |= CURL_CSELECT_ERR;
+        curl_multi_socket_action(
+            g_curlMulti, events[i].data.fd, mask, &iRunning
+        );
+    }
+    if (g_curl_timeout >= 0 && dtime() >= g_curl_timeout) {
+        // the callback may set a new timeout
+        //
+        g_curl_timeout = -1;
+        curl_multi_socket_action(
+            g_curlMulti, CURL_SOCKET_TIMEOUT, 0, &iRunning
+        );
+    }
+    handle_messages();
+}
+#else
+void HTTP_OP_SET::got_select(FDSET_GROUP&, double timeout) {
     int iRunning = 0;  // curl flags for max # of fds & # running queries
     CURLMcode curlMErr;
 
@@ -1074,9 +1170,17 @@ void HTTP_OP_SET::got_select(FDSET_GROUP&, double timeout) {
         if (curlMErr != CURLM_CALL_MULTI_PERFORM) break;
         if (dtime() - gstate.now > timeout) break;
     }
+    handle_messages();
+}
+#endif
+
+// read messages from curl about finished transfers
+//
+void HTTP_OP_SET::handle_messages() {
+    int iNumMsg;
+    HTTP_OP* hop = NULL;
+    CURLMsg *pcurlMsg = NULL;
 
-    // read messages from curl that may have come in from the above loop
-    //
     while (1) {
         pcurlMsg = curl_multi_info_read(g_curlMulti, &iNumMsg);
         if (!pcurlMsg) break;
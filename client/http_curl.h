@@ -193,8 +193,18 @@ public:
     double bytes_up, bytes_down;
         // total bytes transferred
 
+#ifdef HAVE_SYS_EPOLL_H
+    int get_epoll_fd();
+        // an epoll set of curl's sockets; see http_curl.cpp
+    double get_timeout();
+        // seconds until curl needs got_events() even if no socket is ready;
+        // -1 if it doesn't
+    void got_events();
+#else
     void get_fdset(FDSET_GROUP&);
     void got_select(FDSET_GROUP&, double);
+#endif
+    void handle_messages();
     HTTP_OP* lookup_curl(CURL* pcurl);
         // lookup by easycurl handle
     void cleanup_temp_files();
@@ -0,0 +1,78 @@
+// This file is part of BOINC.
+// https://boinc.berkeley.edu
+// Copyright (C) 2026 University of California
+//
+// BOINC is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+// BOINC is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with BOINC.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef BOINC_OBJ_INDEX_H
+#define BOINC_OBJ_INDEX_H
+
+#include <string>
+#include <unordered_map>
+
+// A hash index of client state objects (RESULT, WORKUNIT, FILE_INFO)
+// by project and name.
+// CLIENT_STATE keeps one alongside each of its vectors of these,
+// so that looking up an object by name doesn't scan the vector;
+// with tens of thousands of jobs or files,
+// the scans made parsing the state file and scheduler replies O(N^2).
+//
+// T must have "project" and "name" members.
+// The project is used only as a key, so it can be NULL.
+//
+template <class T> class OBJ_INDEX {
+    struct KEY {
+        const void* project;
+        std::string name;
+        KEY(const void* p, const char* n): project(p), name(n) {}
+        bool operator==(const KEY& k) const {
+            return project == k.project && name == k.name;
+        }
+    };
+    struct KEY_HASH {
+        size_t operator()(const KEY& k) const {
+            return std::hash<std::string>()(k.name)
+                ^ std::hash<const void*>()(k.project);
+        }
+    };
+    std::unordered_map<KEY, T*, KEY_HASH> map;
+public:
+    // If there's already an object with the same project and name,
+    // keep that one; that's what a scan of the vector would find.
+    //
+    void add(T* obj) {
+        map.emplace(KEY(obj->project, obj->name), obj);
+    }
+    void remove(T* obj) {
+        typename std::unordered_map<KEY, T*, KEY_HASH>::iterator i =
+            map.find(KEY(obj->project, obj->name));
+        if (i != map.end() && i->second == obj) {
+            map.erase(i);
+        }
+    }
+    T* lookup(const void* project, const char* name) const {
+        typename std::unordered_map<KEY, T*, KEY_HASH>::const_iterator i =
+            map.find(KEY(project, name));
+        if (i == map.end()) return NULL;
+        return i->second;
+    }
+    void clear() {
+        map.clear();
+    }
+    size_t size() const {
+        return map.size();
+    }
+};
+
+#endif
@@ -516,17 +516,26 @@ bool PERS_FILE_XFER_SET::poll() {
 
     // try to finish ones we've already started
     //
+    // A transfer that finished or failed changes the file
+    // and the project's transfer backoff
+    //
     for (PERS_FILE_XFER* pfx: pers_file_xfers) {
         if (!pfx->last_bytes_xferred) continue;
-        action |= pfx->poll();
+        if (pfx->poll()) {
+            gstate.journal_file_info(pfx->fip);
+            gstate.journal_project(pfx->fip->project);
+            action = true;
+        }
     }
     for (PERS_FILE_XFER* pfx: pers_file_xfers) {
         if (pfx->last_bytes_xferred) continue;
-        action |= pfx->poll();
+        if (pfx->poll()) {
+            gstate.journal_file_info(pfx->fip);
+            gstate.journal_project(pfx->fip->project);
+            action = true;
+        }
     }
 
-    if (action) gstate.set_client_state_dirty("pers_file_xfer_set poll");
-
     return action;
 }
 
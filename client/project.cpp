@@ -128,6 +128,7 @@ void PROJECT::init() {
     upload_backoff.is_upload = true;
     download_backoff.is_upload = false;
     app_test = false;
+    journal_pending = false;
 
 #ifdef SIM
     idle_time = 0;
@@ -216,6 +216,8 @@ struct PROJECT : PROJ_AM {
     bool app_test;
         // this is the project created by app_test_init();
         // use slots/app_test for its jobs
+    bool journal_pending;
+        // write to state file journal; see CLIENT_STATE::journal_project()
 
     ///////////////// member functions /////////////////
 
@@ -78,6 +78,7 @@ void RESULT::clear() {
     suspended_via_gui = false;
     report_immediately = false;
     not_started = false;
+    journal_pending = false;
     name_md5.clear();
     index = 0;
     app = NULL;
@@ -213,6 +214,26 @@ int RESULT::parse_state(XML_PARSER& xp) {
     return ERR_XML_PARSE;
 }
 
+void RESULT::copy_state_fields(RESULT& r) {
+    ready_to_report = r.ready_to_report;
+    completed_time = r.completed_time;
+    got_server_ack = r.got_server_ack;
+    final_cpu_time = r.final_cpu_time;
+    final_elapsed_time = r.final_elapsed_time;
+    final_peak_rss = r.final_peak_rss;
+    final_peak_swap_usage = r.final_peak_swap_usage;
+    final_peak_disk_usage = r.final_peak_disk_usage;
+    fpops_per_cpu_sec = r.fpops_per_cpu_sec;
+    fpops_cumulative = r.fpops_cumulative;
+    intops_per_cpu_sec = r.intops_per_cpu_sec;
+    intops_cumulative = r.intops_cumulative;
+    _state = r._state;
+    exit_status = r.exit_status;
+    stderr_out = r.stderr_out;
+    suspended_via_gui = r.suspended_via_gui;
+    report_immediately = r.report_immediately;
+}
+
 // write result descriptor to state file, GUI RPC reply, or sched request
 //
 int RESULT::write(MIOFILE& out, bool to_server) {
@@ -682,6 +703,7 @@ static const char* result_state_name(int val) {
 
 void RESULT::set_state(int val, const char* where) {
     _state = val;
+    gstate.journal_result(this);
     if (log_flags.task_debug) {
         msg_printf(project, MSG_INFO,
             "[task] result state=%s for %s from %s",
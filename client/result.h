@@ -82,6 +82,8 @@ struct RESULT {
     bool suspended_via_gui;
     bool report_immediately;
     bool not_started;   // temp for CPU sched
+    bool journal_pending;
+        // write to state file journal; see CLIENT_STATE::journal_result()
 
     std::string name_md5;   // see sort_results();
     int index;              // index in results vector
@@ -99,6 +101,8 @@ struct RESULT {
     void clear();
     int parse_server(XML_PARSER&);
     int parse_state(XML_PARSER&);
+    void copy_state_fields(RESULT&);
+        // copy the fields that change as the job runs
     int parse_name(XML_PARSER&, const char* end_tag);
     int write(MIOFILE&, bool to_server);
     int write_gui(MIOFILE&, bool check_resources = false);
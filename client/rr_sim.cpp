@@ -76,6 +76,11 @@ static inline void set_bits(
 //
 struct RR_SIM {
     vector<RESULT*> active_jobs;
+    vector<PROJECT*> project_heap;
+        // used in pick_jobs_to_run(); a member to avoid reallocating it
+    vector<RSC_PROJECT_WORK_FETCH*> mc_limited;
+        // project/resources at a max concurrent limit
+        // in the last pick_jobs_to_run()
 
     inline void activate(RESULT* rp) {
         PROJECT* p = rp->project;
@@ -116,6 +121,7 @@ struct RR_SIM {
 
     void init_pending_lists();
     void pick_jobs_to_run(double reltime);
+    void set_mc_limit_reltime(double reltime);
     void simulate();
 
     RR_SIM() {}
@@ -217,6 +223,7 @@ void RR_SIM::pick_jobs_to_run(double reltime) {
         msg_printf(NULL, MSG_INFO, "pick_jobs_to_run() start");
     }
     active_jobs.clear();
+    mc_limited.clear();
 
     if (have_max_concurrent) {
         max_concurrent_init();
@@ -234,7 +241,7 @@ void RR_SIM::pick_jobs_to_run(double reltime) {
     // loop over resource types; do the GPUs first
     //
     for (int rt=coprocs.n_rsc-1; rt>=0; rt--) {
-        vector<PROJECT*> project_heap;
+        project_heap.clear();
 
         if (rt) rsc_work_fetch[rt].sim_nused = 0;
 
@@ -301,6 +308,7 @@ void RR_SIM::pick_jobs_to_run(double reltime) {
                     switch (max_concurrent_exceeded(rp)) {
                     case CONCURRENT_LIMIT_PROJECT:
                         rsc_pwf.last_mc_limit_reltime = reltime;
+                        mc_limited.push_back(&rsc_pwf);
                         p->pwf.at_max_concurrent_limit = true;
                         if (log_flags.rr_simulation) {
                             msg_printf(p, MSG_INFO,
@@ -314,6 +322,7 @@ void RR_SIM::pick_jobs_to_run(double reltime) {
                         //
                         p->pwf.at_max_concurrent_limit = true;
                         rsc_pwf.last_mc_limit_reltime = reltime;
+                        mc_limited.push_back(&rsc_pwf);
                         if (log_flags.rr_simulation) {
                             msg_printf(p, MSG_INFO,
                                 "[rr_sim] at app max concurrent for %s; t %f",
@@ -354,9 +363,12 @@ void RR_SIM::pick_jobs_to_run(double reltime) {
                 pop_heap(project_heap.begin(), project_heap.end());
                 project_heap.pop_back();
             } else if (!rp->rrsim_done) {
-                // Otherwise reshuffle the project heap
+                // Otherwise reshuffle the project heap.
+                // Only p's priority changed;
+                // take it out and put it back rather than rebuilding the heap
                 //
-                make_heap(project_heap.begin(), project_heap.end());
+                pop_heap(project_heap.begin(), project_heap.end());
+                push_heap(project_heap.begin(), project_heap.end());
             }
         }
     }
@@ -369,6 +381,16 @@ void RR_SIM::pick_jobs_to_run(double reltime) {
     }
 }
 
+// Called instead of pick_jobs_to_run() in a time-slice step,
+// when the same jobs are active.
+// Record the max concurrent limits as it would have.
+//
+void RR_SIM::set_mc_limit_reltime(double reltime) {
+    for (RSC_PROJECT_WORK_FETCH* rsc_pwf: mc_limited) {
+        rsc_pwf->last_mc_limit_reltime = reltime;
+    }
+}
+
 // compute the number of idle instances (count - nused)
 // Called at the start of RR simulation,
 // after the initial assignment of jobs
@@ -479,8 +501,20 @@ void RR_SIM::simulate() {
     double buf_end = gstate.now + gstate.work_buf_total();
     double sim_now = gstate.now;
     bool first = true;
+    bool job_finished = true;
     while (1) {
-        pick_jobs_to_run(sim_now-gstate.now);
+        // What pick_jobs_to_run() picks depends only on which jobs are done;
+        // the project priorities it uses are based on REC
+        // at the start of the simulation, not on rec_temp.
+        // So if the last step was a time slice (no job finished),
+        // the same jobs are still active; don't pick them again.
+        // With long jobs, most steps are time slices.
+        //
+        if (job_finished) {
+            pick_jobs_to_run(sim_now-gstate.now);
+        } else {
+            set_mc_limit_reltime(sim_now-gstate.now);
+        }
         if (first) {
             record_nidle_now();
             first = false;
@@ -511,6 +545,7 @@ void RR_SIM::simulate() {
         }
         if (delta_t > 3600) {
             rpbest = 0;
+            job_finished = false;
 
             // limit the granularity
             //
@@ -526,6 +561,7 @@ void RR_SIM::simulate() {
             }
         } else {
             rpbest->rrsim_done = true;
+            job_finished = true;
             pbest = rpbest->project;
             if (log_flags.rr_simulation) {
                 char buf[256];
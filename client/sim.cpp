@@ -278,6 +278,7 @@ void CLIENT_STATE::handle_completed_results(PROJECT* p) {
                 spp->project_results.nresults_met_deadline++;
             }
             html_msg += buf;
+            result_index.remove(rp);
             delete rp;
             result_iter = results.erase(result_iter);
         } else {
@@ -443,7 +444,7 @@ bool CLIENT_STATE::simulate_rpc(PROJECT* p) {
 
         sent_something = true;
         rp->set_state(RESULT_FILES_DOWNLOADED, "simulate_rpc");
-        results.push_back(rp);
+        add_result(rp);
         new_results.push_back(rp);
 #if 0
         snprintf(buf, sizeof(buf), "got job %s: CPU time %.2f, deadline %s<br>",
@@ -1356,6 +1357,7 @@ void cull_projects() {
     while (ri != gstate.results.end()) {
         RESULT* rp = *ri;
         if (rp->project->ignore) {
+            gstate.result_index.remove(rp);
             ri = gstate.results.erase(ri);
         } else {
             ++ri;
@@ -0,0 +1,91 @@
+// This file is part of BOINC.
+// https://boinc.berkeley.edu
+// Copyright (C) 2026 University of California
+//
+// BOINC is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+// BOINC is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with BOINC.  If not, see <http://www.gnu.org/licenses/>.
+
+// See state_journal.h
+
+#ifdef _WIN32
+#include "boinc_win.h"
+#else
+#include "config.h"
+#endif
+
+#include "filesys.h"
+#include "parse.h"
+
+#include "file_names.h"
+#include "state_journal.h"
+
+int STATE_JOURNAL::open(MFILE& mf) {
+    int retval;
+
+    // if we haven't written anything since the last state file,
+    // truncate; there may be a journal for an older one
+    //
+    retval = mf.open(STATE_JOURNAL_NAME, size ? "a" : "w");
+    if (retval) return retval;
+    if (!size) {
+        mf.printf("<state_journal_seqno>%d</state_journal_seqno>\n", seqno);
+    }
+    return 0;
+}
+
+int STATE_JOURNAL::close(MFILE& mf) {
+    double old_size = size;
+    int retval = mf.close();
+    if (file_size(STATE_JOURNAL_NAME, size)) {
+        size = 0;
+    }
+    if (size > old_size) {
+        bytes_written += size - old_size;
+    }
+    return retval;
+}
+
+void STATE_JOURNAL::state_file_written(double nbytes, double now) {
+    seqno++;
+    boinc_delete_file(STATE_JOURNAL_NAME);
+    size = 0;
+    state_file_size = nbytes;
+    state_file_time = now;
+    bytes_written += nbytes;
+}
+
+bool STATE_JOURNAL::need_compaction(double now) {
+    if (!size) return false;
+    if (size > STATE_JOURNAL_MIN_SIZE
+        && size > STATE_JOURNAL_MAX_FRAC*state_file_size
+    ) {
+        return true;
+    }
+    return now > state_file_time + STATE_JOURNAL_MAX_AGE;
+}
+
+FILE* STATE_JOURNAL::open_for_replay() {
+    char buf[256];
+    int n;
+
+    FILE* f = boinc_fopen(STATE_JOURNAL_NAME, "r");
+    if (!f) return NULL;
+    if (!fgets(buf, sizeof(buf), f)
+        || !parse_int(buf, "<state_journal_seqno>", n)
+        || n != seqno
+    ) {
+        fclose(f);
+        return NULL;
+    }
+    return f;
+}
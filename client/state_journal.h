@@ -0,0 +1,114 @@
+// This file is part of BOINC.
+// https://boinc.berkeley.edu
+// Copyright (C) 2026 University of California
+//
+// BOINC is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+// BOINC is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with BOINC.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef BOINC_STATE_JOURNAL_H
+#define BOINC_STATE_JOURNAL_H
+
+#include <cstdio>
+#include <vector>
+
+#include "mfile.h"
+
+// The state file journal.
+//
+// Writing client_state.xml means writing every project, file, job and task;
+// with a large queue that's megabytes.
+// Most changes involve a few objects:
+// a task's state, a file's status, the running tasks.
+// These are appended to a journal file (client_state_journal.xml)
+// instead, and the state file is rewritten ("compacted")
+// only when something else changes,
+// or when the journal gets large relative to the state file, or old.
+//
+// Each state file has a sequence number (<state_journal_seqno>),
+// and the journal starts with the number of the state file it follows.
+// A journal for some other state file
+// (e.g. if we crashed after writing client_state_next.xml)
+// is ignored.
+// Records are written whole with one write();
+// on startup, records are replayed until a bad or partial one.
+//
+// This class handles the file;
+// CLIENT_STATE (cs_statefile.cpp) writes and replays the records.
+
+// compact if the journal is at least this big ...
+//
+#define STATE_JOURNAL_MIN_SIZE      65536
+// ... and bigger than this fraction of the state file
+//
+#define STATE_JOURNAL_MAX_FRAC      0.5
+// compact at least this often
+//
+#define STATE_JOURNAL_MAX_AGE       3600
+
+struct STATE_JOURNAL {
+    int seqno;
+        // sequence number of the current state file
+    double size;
+        // size of the journal file
+    double state_file_size;
+    double state_file_time;
+        // size and write time of the current state file
+    double bytes_written;
+        // total written to the state file and journal
+
+    STATE_JOURNAL() {
+        seqno = 0;
+        size = 0;
+        state_file_size = 0;
+        state_file_time = 0;
+        bytes_written = 0;
+    }
+    int open(MFILE&);
+        // open the journal for appending;
+        // if it's empty, write the header
+    int close(MFILE&);
+    void state_file_written(double nbytes, double now);
+        // a state file with sequence number seqno+1 has been written;
+        // start a new journal
+    bool need_compaction(double now);
+    FILE* open_for_replay();
+        // if there's a journal for the current state file,
+        // open it and skip the header; else return NULL
+};
+
+// Replace a list of objects (e.g. the active tasks)
+// with the ones added by parse().
+// The old objects are moved aside first, so parse() sees an empty list;
+// they're deleted if it succeeds.
+// If it fails, the objects it added are deleted
+// and the old ones restored.
+//
+template <class T, class F>
+int replace_list(std::vector<T*>& list, F parse) {
+    std::vector<T*> old_list;
+    old_list.swap(list);
+    int retval = parse();
+    if (retval) {
+        for (T* p: list) {
+            delete p;
+        }
+        list.swap(old_list);
+        return retval;
+    }
+    for (T* p: old_list) {
+        delete p;
+    }
+    return 0;
+}
+
+#endif
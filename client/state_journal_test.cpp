@@ -0,0 +1,386 @@
+// This file is part of BOINC.
+// https://boinc.berkeley.edu
+// Copyright (C) 2026 University of California
+//
+// BOINC is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+// BOINC is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with BOINC.  If not, see <http://www.gnu.org/licenses/>.
+
+// Benchmark for the state file journal (state_journal.h).
+// Built from the client's objects: "make state_journal_test".
+//
+// usage: state_journal_test options
+//  [--ncpus N]         number of running tasks (default 64)
+//  [--njobs N]         jobs in the queue (default 2000)
+//  [--job_minutes x]   job runtime (default 2)
+//  [--rpc_minutes x]   time between scheduler RPCs (default 10)
+//  [--hours x]         simulated time (default 1)
+//
+// Jobs finish one at a time, round-robin over the running tasks.
+// Each completion is three state changes, each followed by
+// write_state_file_if_needed():
+// the task exits, the next job starts, the output file is uploaded.
+// At each RPC the uploaded jobs are reported
+// and come back as new jobs, and the state file is rewritten.
+//
+// This is done twice: with the journal,
+// and with every change rewriting the state file.
+// Prints the bytes written and the time spent writing for each.
+// Then the state file and journal are parsed again,
+// and the jobs, files and tasks are checked against the ones in memory.
+//
+// Works in the directory state_journal_test_dir, and removes it.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "filesys.h"
+#include "str_util.h"
+#include "util.h"
+
+#include "client_state.h"
+#include "file_names.h"
+#include "project.h"
+#include "result.h"
+
+using std::string;
+using std::vector;
+
+#define DIR_NAME    "state_journal_test_dir"
+#define URL         "https://project.test/"
+#define PLATFORM    "x86_64-pc-linux-gnu"
+
+int ncpus = 64;
+int njobs = 2000;
+double job_minutes = 2;
+double rpc_minutes = 10;
+double hours = 1;
+
+static void write_initial_state() {
+    FILE* f = fopen(STATE_FILE_NAME, "w");
+    if (!f) {
+        fprintf(stderr, "can't create %s\n", STATE_FILE_NAME);
+        exit(1);
+    }
+    fprintf(f,
+        "<client_state>\n"
+        "<project>\n"
+        "    <master_url>" URL "</master_url>\n"
+        "    <project_name>test</project_name>\n"
+        "</project>\n"
+        "<app>\n"
+        "    <name>app</name>\n"
+        "</app>\n"
+        "<app_version>\n"
+        "    <app_name>app</app_name>\n"
+        "    <version_num>1</version_num>\n"
+        "    <platform>" PLATFORM "</platform>\n"
+        "</app_version>\n"
+    );
+    for (int i=0; i<njobs; i++) {
+        fprintf(f,
+            "<file>\n"
+            "    <name>in_%d</name>\n"
+            "    <nbytes>1000000</nbytes>\n"
+            "    <max_nbytes>0</max_nbytes>\n"
+            "    <md5_cksum>0123456789abcdef0123456789abcdef</md5_cksum>\n"
+            "    <status>1</status>\n"
+            "    <url>https://project.test/download/in_%d</url>\n"
+            "</file>\n"
+            "<file>\n"
+            "    <name>out_%d</name>\n"
+            "    <max_nbytes>1000000</max_nbytes>\n"
+            "    <status>0</status>\n"
+            "    <upload_when_present/>\n"
+            "    <url>https://project.test/upload</url>\n"
+            "</file>\n"
+            "<workunit>\n"
+            "    <name>wu_%d</name>\n"
+            "    <app_name>app</app_name>\n"
+            "    <version_num>1</version_num>\n"
+            "    <rsc_fpops_est>1e12</rsc_fpops_est>\n"
+            "    <rsc_fpops_bound>1e14</rsc_fpops_bound>\n"
+            "    <rsc_memory_bound>1e8</rsc_memory_bound>\n"
+            "    <rsc_disk_bound>1e8</rsc_disk_bound>\n"
+            "    <file_ref>\n"
+            "        <file_name>in_%d</file_name>\n"
+            "        <open_name>in</open_name>\n"
+            "    </file_ref>\n"
+            "</workunit>\n"
+            "<result>\n"
+            "    <name>r_%d</name>\n"
+            "    <wu_name>wu_%d</wu_name>\n"
+            "    <version_num>1</version_num>\n"
+            "    <platform>" PLATFORM "</platform>\n"
+            "    <state>2</state>\n"
+            "    <received_time>%d</received_time>\n"
+            "    <report_deadline>1000000</report_deadline>\n"
+            "    <file_ref>\n"
+            "        <file_name>out_%d</file_name>\n"
+            "        <open_name>out</open_name>\n"
+            "    </file_ref>\n"
+            "</result>\n",
+            i, i, i, i, i, i, i, i, i
+        );
+    }
+    fprintf(f, "</client_state>\n");
+    fclose(f);
+}
+
+// delete everything but the projects
+//
+static void clear_state() {
+    for (ACTIVE_TASK* atp: gstate.active_tasks.active_tasks) delete atp;
+    gstate.active_tasks.active_tasks.clear();
+    for (RESULT* rp: gstate.results) delete rp;
+    gstate.results.clear();
+    for (WORKUNIT* wup: gstate.workunits) delete wup;
+    gstate.workunits.clear();
+    for (APP_VERSION* avp: gstate.app_versions) delete avp;
+    gstate.app_versions.clear();
+    for (APP* app: gstate.apps) delete app;
+    gstate.apps.clear();
+    for (FILE_INFO* fip: gstate.file_infos) delete fip;
+    gstate.file_infos.clear();
+    gstate.state_journal = STATE_JOURNAL();
+}
+
+static void parse_state() {
+    clear_state();
+    int retval = gstate.parse_state_file();
+    if (retval) {
+        fprintf(stderr, "parse_state_file(): %s\n", boincerror(retval));
+        exit(1);
+    }
+}
+
+static void start_task(RESULT* rp, int slot) {
+    ACTIVE_TASK* atp = new ACTIVE_TASK;
+    atp->slot = slot;
+    atp->init(rp);
+    gstate.active_tasks.active_tasks.push_back(atp);
+    gstate.journal_active_tasks();
+}
+
+// next job that hasn't started
+//
+static RESULT* next_job(size_t& next) {
+    for (size_t i=0; i<gstate.results.size(); i++) {
+        RESULT* rp = gstate.results[next];
+        next = (next + 1) % gstate.results.size();
+        if (rp->state() != RESULT_FILES_DOWNLOADED) continue;
+        if (gstate.lookup_active_task_by_result(rp)) continue;
+        return rp;
+    }
+    return NULL;
+}
+
+// Run the workload.
+// Return the bytes written, and the time spent writing.
+//
+static void run(bool use_journal, double& nbytes, double& write_time) {
+    PROJECT* p = gstate.projects[0];
+    size_t next = 0;
+    double next_rpc = rpc_minutes*60;
+    double dt = job_minutes*60/ncpus;
+    int ncompleted = 0;
+
+    gstate.now = 0;
+    gstate.state_journal.state_file_time = 0;
+    gstate.state_journal.bytes_written = 0;
+    write_time = 0;
+
+    for (int i=0; i<ncpus; i++) {
+        RESULT* rp = next_job(next);
+        if (!rp) break;
+        start_task(rp, i);
+    }
+    gstate.set_client_state_dirty("start");
+    gstate.write_state_file_if_needed();
+
+    auto write = [&]() {
+        if (!use_journal) gstate.set_client_state_dirty("test");
+        double t = dtime();
+        gstate.write_state_file_if_needed();
+        write_time += dtime() - t;
+    };
+
+    for (gstate.now = dt; gstate.now < hours*3600; gstate.now += dt) {
+        if (gstate.active_tasks.active_tasks.empty()) break;
+
+        // the task in the next slot finishes
+        //
+        vector<ACTIVE_TASK*>& tasks = gstate.active_tasks.active_tasks;
+        int slot = ncompleted++ % ncpus;
+        ACTIVE_TASK* atp = NULL;
+        size_t j;
+        for (j=0; j<tasks.size(); j++) {
+            if (tasks[j]->slot == slot) {
+                atp = tasks[j];
+                break;
+            }
+        }
+        if (!atp) continue;
+        RESULT* rp = atp->result;
+        FILE_INFO* fip = rp->output_files[0].file_info;
+        fip->status = FILE_PRESENT;
+        fip->nbytes = 100000;
+        rp->final_elapsed_time = job_minutes*60;
+        rp->set_state(RESULT_FILES_UPLOADING, "test");
+        gstate.journal_project(p);
+        tasks.erase(tasks.begin()+j);
+        delete atp;
+        gstate.journal_active_tasks();
+        write();
+
+        RESULT* next_rp = next_job(next);
+        if (next_rp) {
+            start_task(next_rp, slot);
+            write();
+        }
+
+        fip->uploaded = true;
+        gstate.journal_file_info(fip);
+        gstate.journal_project(p);
+        rp->set_state(RESULT_FILES_UPLOADED, "test");
+        write();
+
+        // report uploaded jobs; they come back as new ones
+        //
+        if (gstate.now >= next_rpc) {
+            next_rpc += rpc_minutes*60;
+            for (RESULT* rp2: gstate.results) {
+                if (rp2->state() != RESULT_FILES_UPLOADED) continue;
+                FILE_INFO* fip2 = rp2->output_files[0].file_info;
+                fip2->status = FILE_NOT_PRESENT;
+                fip2->uploaded = false;
+                fip2->nbytes = 0;
+                rp2->final_elapsed_time = 0;
+                rp2->set_state(RESULT_FILES_DOWNLOADED, "test");
+            }
+            gstate.set_client_state_dirty("RPC");
+            write();
+        }
+    }
+    nbytes = gstate.state_journal.bytes_written;
+}
+
+// the parts of the state that the journal records
+//
+static string summary() {
+    string s;
+    char buf[1024];
+    for (RESULT* rp: gstate.results) {
+        FILE_INFO* fip = rp->output_files[0].file_info;
+        snprintf(buf, sizeof(buf), "%s %d %.0f %s %d %d %.0f\n",
+            rp->name, rp->state(), rp->final_elapsed_time,
+            fip->name, fip->status, fip->uploaded?1:0, fip->nbytes
+        );
+        s += buf;
+    }
+    for (ACTIVE_TASK* atp: gstate.active_tasks.active_tasks) {
+        snprintf(buf, sizeof(buf), "task %s %d\n",
+            atp->result->name, atp->slot
+        );
+        s += buf;
+    }
+    return s;
+}
+
+static void usage() {
+    fprintf(stderr,
+        "usage: state_journal_test [--ncpus N] [--njobs N] [--job_minutes x]\n"
+        "    [--rpc_minutes x] [--hours x]\n"
+    );
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    for (int i=1; i<argc; i++) {
+        if (i == argc-1) usage();
+        if (!strcmp(argv[i], "--ncpus")) {
+            ncpus = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--njobs")) {
+            njobs = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--job_minutes")) {
+            job_minutes = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--rpc_minutes")) {
+            rpc_minutes = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--hours")) {
+            hours = atof(argv[++i]);
+        } else {
+            usage();
+        }
+    }
+    if (ncpus <= 0 || njobs < ncpus || job_minutes <= 0 || rpc_minutes <= 0) {
+        usage();
+    }
+
+    clean_out_dir(DIR_NAME);
+    boinc_mkdir(DIR_NAME);
+    if (chdir(DIR_NAME)) {
+        fprintf(stderr, "can't cd to %s\n", DIR_NAME);
+        exit(1);
+    }
+
+    PROJECT* p = new PROJECT;
+    safe_strcpy(p->master_url, URL);
+    gstate.projects.push_back(p);
+    gstate.add_platform(PLATFORM);
+
+    double full_bytes, full_time, journal_bytes, journal_time;
+    write_initial_state();
+    parse_state();
+    double state_file_size = 0;
+    file_size(STATE_FILE_NAME, state_file_size);
+    run(false, full_bytes, full_time);
+
+    boinc_delete_file(STATE_JOURNAL_NAME);
+    write_initial_state();
+    parse_state();
+    run(true, journal_bytes, journal_time);
+
+    printf(
+        "%d jobs, %d CPUs, state file %.0f bytes\n"
+        "without journal: %.0f bytes/hour, %.3f sec/hour writing\n"
+        "with journal:    %.0f bytes/hour, %.3f sec/hour writing\n",
+        njobs, ncpus, state_file_size,
+        full_bytes/hours, full_time/hours,
+        journal_bytes/hours, journal_time/hours
+    );
+
+    // restart from the state file and journal
+    //
+    string before = summary();
+    double journal_size = gstate.state_journal.size;
+    parse_state();
+    string after = summary();
+    int retval = 0;
+    if (before == after) {
+        printf("replay of %.0f byte journal: state matches\n", journal_size);
+    } else {
+        printf("replay of %.0f byte journal: state differs\n", journal_size);
+        retval = 1;
+    }
+
+    clear_state();
+    if (chdir("..")) {
+        fprintf(stderr, "can't cd to ..\n");
+        exit(1);
+    }
+    clean_out_dir(DIR_NAME);
+    boinc_rmdir(DIR_NAME);
+    return retval;
+}
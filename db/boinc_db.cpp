@@ -22,6 +22,7 @@
 #include <ctime>
 #include <unistd.h>
 #include <cmath>
+#include <climits>
 
 // For machines with finite() defined in ieeefp.h
 #if HAVE_IEEEFP_H
@@ -161,6 +162,11 @@ DB_WORK_ITEM::DB_WORK_ITEM(DB_CONN* dc) :
 }
 DB_IN_PROGRESS_RESULT::DB_IN_PROGRESS_RESULT(DB_CONN* dc) :
     DB_BASE_SPECIAL(dc?dc:&boinc_db){}
+DB_HOST_USER_TEAM::DB_HOST_USER_TEAM(DB_CONN* dc) :
+    DB_BASE_SPECIAL(dc?dc:&boinc_db), host(dc), user(dc), team(dc),
+    have_user(false), have_team(false) {}
+DB_WU_QUEUE::DB_WU_QUEUE(DB_CONN* dc) :
+    DB_BASE_SPECIAL(dc?dc:&boinc_db){}
 DB_SCHED_RESULT_ITEM_SET::DB_SCHED_RESULT_ITEM_SET(DB_CONN* dc) :
     DB_BASE_SPECIAL(dc?dc:&boinc_db){}
 DB_FILE::DB_FILE(DB_CONN* dc) :
@@ -699,12 +705,13 @@ int DB_HOST::update_diff_validator(HOST& h) {
     return db->do_query(query);
 }
 
-// Update fields that differ from the argument HOST.
+// Get the "set" clause for fields that differ from the argument HOST
+// (empty if none).
 // Called from scheduler (handle_request.cpp),
 // so only include fields modified by the scheduler.
 //
-int DB_HOST::update_diff_sched(HOST& h) {
-    char buf[BLOB_SIZE], updates[BLOB_SIZE], query[BLOB_SIZE];
+void DB_HOST::get_diff_sched(HOST& h, char* updates) {
+    char buf[BLOB_SIZE];
     strcpy(updates, "");
     if (rpc_seqno != h.rpc_seqno) {
         sprintf(buf, " rpc_seqno=%d,", rpc_seqno);
@@ -898,8 +905,13 @@ int DB_HOST::update_diff_sched(HOST& h) {
     }
 
     int n = strlen(updates);
-    if (n == 0) return 0;
-    updates[n-1] = 0;        // trim the final comma
+    if (n) updates[n-1] = 0;        // trim the final comma
+}
+
+int DB_HOST::update_diff_sched(HOST& h) {
+    char updates[BLOB_SIZE], query[BLOB_SIZE];
+    get_diff_sched(h, updates);
+    if (!strlen(updates)) return 0;
     sprintf(query, "update host set %s where id=%lu", updates, id);
     return db->do_query(query);
 }
@@ -1649,12 +1661,9 @@ int DB_TRANSITIONER_ITEM_SET::enumerate(
     int wu_id_modulus, int wu_id_remainder,
     std::vector<TRANSITIONER_ITEM>& items
 ) {
-    int retval;
-    char query[MAX_QUERY_LEN];
-    char mod_clause[256];;
+    char where_clause[512] = "";
+    char mod_clause[256];
     char time_clause[256];
-    MYSQL_ROW row;
-    TRANSITIONER_ITEM new_item;
 
     if (!cursor.active) {
         sprintf(time_clause, " wu.transition_time < %d ", transition_time);
@@ -1674,10 +1683,37 @@ int DB_TRANSITIONER_ITEM_SET::enumerate(
         } else {
             strcpy(mod_clause, "");
         }
+        sprintf(where_clause, "%s %s", time_clause, mod_clause);
+    }
+    return enumerate_where(where_clause, nresult_limit, items);
+}
 
+int DB_TRANSITIONER_ITEM_SET::enumerate_ids(
+    const char* wu_ids, std::vector<TRANSITIONER_ITEM>& items
+) {
+    string where_clause;
 
-        sprintf(query,
-            "SELECT "
+    if (!cursor.active) {
+        where_clause = " wu.id in (";
+        where_clause += wu_ids;
+        where_clause += ") ";
+    }
+
+    // no limit, so that the last WU isn't cut off
+    //
+    return enumerate_where(where_clause.c_str(), INT_MAX, items);
+}
+
+int DB_TRANSITIONER_ITEM_SET::enumerate_where(
+    const char* where_clause, int nresult_limit,
+    std::vector<TRANSITIONER_ITEM>& items
+) {
+    int retval;
+    MYSQL_ROW row;
+    TRANSITIONER_ITEM new_item;
+
+    if (!cursor.active) {
+        string query = "SELECT "
             "   wu.id, "
             "   wu.name, "
             "   wu.appid, "
@@ -1714,14 +1750,16 @@ int DB_TRANSITIONER_ITEM_SET::enumerate(
             "FROM "
             "   workunit AS wu "
             "       LEFT JOIN result AS res ON wu.id = res.workunitid "
-            "WHERE "
-            "   %s %s and transitioner_flags<>%d "
-            "LIMIT "
-            "   %d ",
-            time_clause, mod_clause, TRANSITION_NONE, nresult_limit
+            "WHERE ";
+        char buf[256];
+        sprintf(buf,
+            " and transitioner_flags<>%d LIMIT %d ",
+            TRANSITION_NONE, nresult_limit
         );
+        query += where_clause;
+        query += buf;
 
-        retval = db->do_query(query);
+        retval = db->do_query(query.c_str());
         if (retval) return mysql_errno(db->mysql);
 
         // the following stores the entire result set in memory
@@ -1838,6 +1876,91 @@ int DB_TRANSITIONER_ITEM_SET::update_workunit(
     return db->do_query(query);
 }
 
+int DB_WU_QUEUE::add(int queue, DB_ID_TYPE wuid) {
+    char query[MAX_QUERY_LEN];
+    sprintf(query,
+        "insert into wu_queue (queue, wuid) values (%d, %lu)",
+        queue, wuid
+    );
+    return db->do_query(query);
+}
+
+int DB_WU_QUEUE::add(int queue, std::vector<DB_ID_TYPE>& wuids) {
+    char buf[256];
+    if (wuids.empty()) return 0;
+    string query = "insert into wu_queue (queue, wuid) values ";
+    for (unsigned int i=0; i<wuids.size(); i++) {
+        sprintf(buf, "%s(%d, %lu)", i?", ":"", queue, wuids[i]);
+        query += buf;
+    }
+    return db->do_query(query.c_str());
+}
+
+int DB_WU_QUEUE::add_names(int queue, std::vector<std::string>& names) {
+    char buf[256], name[1024];
+    if (names.empty()) return 0;
+    sprintf(buf,
+        "insert into wu_queue (queue, wuid) "
+        "select %d, id from workunit where name in (",
+        queue
+    );
+    string query = buf;
+    for (unsigned int i=0; i<names.size(); i++) {
+        safe_strcpy(name, names[i].c_str());
+        escape_string(name, sizeof(name));
+        query += i?", '":"'";
+        query += name;
+        query += "'";
+    }
+    query += ")";
+    return db->do_query(query.c_str());
+}
+
+int DB_WU_QUEUE::get(
+    int queue, int limit, int mod_n, int mod_i,
+    std::vector<WU_QUEUE_ITEM>& items
+) {
+    char query[MAX_QUERY_LEN], mod_clause[256];
+    int retval;
+    MYSQL_ROW row;
+    MYSQL_RES* rp;
+
+    items.clear();
+    if (mod_n) {
+        sprintf(mod_clause, " and wuid %% %d = %d", mod_n, mod_i);
+    } else {
+        strcpy(mod_clause, "");
+    }
+    sprintf(query,
+        "select id, wuid from wu_queue where queue=%d %s order by id limit %d",
+        queue, mod_clause, limit
+    );
+    retval = db->do_query(query);
+    if (retval) return retval;
+    rp = mysql_store_result(db->mysql);
+    if (!rp) return mysql_errno(db->mysql);
+    while ((row = mysql_fetch_row(rp))) {
+        WU_QUEUE_ITEM item;
+        item.id = atol(row[0]);
+        item.wuid = atol(row[1]);
+        items.push_back(item);
+    }
+    mysql_free_result(rp);
+    return 0;
+}
+
+int DB_WU_QUEUE::remove(std::vector<WU_QUEUE_ITEM>& items) {
+    char buf[256];
+    if (items.empty()) return 0;
+    string query = "delete from wu_queue where id in (";
+    for (unsigned int i=0; i<items.size(); i++) {
+        sprintf(buf, "%s%lu", i?",":"", items[i].id);
+        query += buf;
+    }
+    query += ")";
+    return db->do_query(query.c_str());
+}
+
 void VALIDATOR_ITEM::parse(MYSQL_ROW& r) {
     int i=0;
     clear();
@@ -2467,6 +2590,84 @@ int DB_SCHED_RESULT_ITEM_SET::update_result(SCHED_RESULT_ITEM& ri) {
     return retval;
 }
 
+// fields written by update_results(), in the order of the values below
+//
+static const char* sched_result_update_fields[] = {
+    "hostid", "received_time", "client_state", "cpu_time",
+    "exit_status", "app_version_num", "server_state", "outcome",
+    "stderr_out", "xml_doc_out", "validate_state", "teamid",
+    "elapsed_time", "peak_working_set_size", "peak_swap_size",
+    "peak_disk_usage"
+};
+#define NSCHED_RESULT_UPDATE_FIELDS \
+    (sizeof(sched_result_update_fields)/sizeof(sched_result_update_fields[0]))
+
+// Update the given results with a single statement of the form
+// UPDATE result SET f1 = CASE id WHEN id1 THEN v1 WHEN id2 THEN v2 ... END,
+// ... WHERE id IN (id1, id2, ...)
+// The caller limits the number and size of items so that
+// the query fits in max_allowed_packet.
+//
+int DB_SCHED_RESULT_ITEM_SET::update_results(
+    std::vector<SCHED_RESULT_ITEM*>& items
+) {
+    char buf[256];
+    unsigned int i, j;
+
+    if (items.empty()) return 0;
+    if (items.size() == 1) return update_result(*items[0]);
+
+    // values[i][j] is the SQL value of field j for item i
+    //
+    std::vector<std::vector<string> > values(items.size());
+    for (i=0; i<items.size(); i++) {
+        SCHED_RESULT_ITEM& ri = *items[i];
+        std::vector<string>& v = values[i];
+        ESCAPE(ri.xml_doc_out);
+        ESCAPE(ri.stderr_out);
+        sprintf(buf, "%lu", ri.hostid); v.push_back(buf);
+        sprintf(buf, "%d", ri.received_time); v.push_back(buf);
+        sprintf(buf, "%d", ri.client_state); v.push_back(buf);
+        sprintf(buf, "%.15e", ri.cpu_time); v.push_back(buf);
+        sprintf(buf, "%d", ri.exit_status); v.push_back(buf);
+        sprintf(buf, "%d", ri.app_version_num); v.push_back(buf);
+        sprintf(buf, "%d", ri.server_state); v.push_back(buf);
+        sprintf(buf, "%d", ri.outcome); v.push_back(buf);
+        v.push_back(string("'") + ri.stderr_out + "'");
+        v.push_back(string("'") + ri.xml_doc_out + "'");
+        sprintf(buf, "%d", ri.validate_state); v.push_back(buf);
+        sprintf(buf, "%lu", ri.teamid); v.push_back(buf);
+        sprintf(buf, "%.15e", ri.elapsed_time); v.push_back(buf);
+        sprintf(buf, "%.0f", ri.peak_working_set_size); v.push_back(buf);
+        sprintf(buf, "%.0f", ri.peak_swap_size); v.push_back(buf);
+        sprintf(buf, "%.0f", ri.peak_disk_usage); v.push_back(buf);
+        UNESCAPE(ri.xml_doc_out);
+        UNESCAPE(ri.stderr_out);
+    }
+
+    string query = "UPDATE result SET ";
+    for (j=0; j<NSCHED_RESULT_UPDATE_FIELDS; j++) {
+        if (j) query += ", ";
+        query += sched_result_update_fields[j];
+        query += " = CASE id";
+        for (i=0; i<items.size(); i++) {
+            sprintf(buf, " WHEN %lu THEN ", items[i]->id);
+            query += buf;
+            query += values[i][j];
+        }
+        query += " END";
+    }
+    query += " WHERE id IN (";
+    for (i=0; i<items.size(); i++) {
+        if (i) query += ",";
+        sprintf(buf, "%lu", items[i]->id);
+        query += buf;
+    }
+    query += ")";
+
+    return db->do_query(query.c_str());
+}
+
 // set transition times of workunits -
 // but only those corresponding to updated results
 // (i.e. those that passed "sanity checks")
@@ -2496,6 +2697,67 @@ int DB_SCHED_RESULT_ITEM_SET::update_workunits() {
     }
 }
 
+// "select host.*, user.*, team.*" returns the columns of the three tables
+// in that order; find where each one starts from the field metadata,
+// so that this doesn't depend on the number of columns in each table.
+//
+int DB_HOST_USER_TEAM::lookup(DB_ID_TYPE hostid) {
+    char query[MAX_QUERY_LEN];
+    int retval;
+    MYSQL_ROW row;
+    MYSQL_RES* rp;
+
+    sprintf(query,
+        "select host.*, user.*, team.* from host"
+        " left join user on user.id=host.userid"
+        " left join team on team.id=user.teamid"
+        " where host.id=%lu",
+        hostid
+    );
+    retval = db->do_query(query);
+    if (retval) return retval;
+    rp = mysql_store_result(db->mysql);
+    if (!rp) return -1;
+
+    unsigned int nfields = mysql_num_fields(rp);
+    MYSQL_FIELD* fields = mysql_fetch_fields(rp);
+    unsigned int user_start = 0, team_start = 0;
+    for (unsigned int i=0; i<nfields; i++) {
+        if (!user_start && !strcmp(fields[i].table, "user")) {
+            user_start = i;
+        }
+        if (!team_start && !strcmp(fields[i].table, "team")) {
+            team_start = i;
+        }
+    }
+    if (!user_start || !team_start) {
+        mysql_free_result(rp);
+        return -1;
+    }
+
+    row = mysql_fetch_row(rp);
+    if (!row) {
+        mysql_free_result(rp);
+        return ERR_DB_NOT_FOUND;
+    }
+    host.db_parse(row);
+
+    // the left joins give NULL IDs if there's no user or team
+    //
+    have_user = (row[user_start] != NULL);
+    if (have_user) {
+        MYSQL_ROW r = row + user_start;
+        user.db_parse(r);
+    }
+    have_team = (row[team_start] != NULL);
+    if (have_team) {
+        MYSQL_ROW r = row + team_start;
+        team.db_parse(r);
+    }
+    mysql_free_result(rp);
+    return 0;
+}
+
 void DB_FILE::db_print(char* buf){
     snprintf(buf, MAX_QUERY_LEN,
         "name='%s', md5sum='%s', size=%.15e",
@@ -186,6 +186,8 @@ public:
     DB_HOST(DB_CONN* p=0);
     DB_ID_TYPE get_id();
     int update_diff_sched(HOST&);
+    void get_diff_sched(HOST&, char* updates);
+        // updates must be at least BLOB_SIZE
     int update_diff_validator(HOST&);
     int fpops_percentile(double percentile, double& fpops);
         // return the given percentile of p_fpops
@@ -285,8 +287,53 @@ public:
         int wu_id_remainder,
         std::vector<TRANSITIONER_ITEM>& items
     );
+    int enumerate_ids(
+        const char* wu_ids,
+        std::vector<TRANSITIONER_ITEM>& items
+    );
+        // same, but for the WUs in a comma-separated ID list,
+        // regardless of transition time.
+        // When the last WU has been returned, cursor.active is false;
+        // calling again would start over.
     int update_result(TRANSITIONER_ITEM&);
     int update_workunit(TRANSITIONER_ITEM&, TRANSITIONER_ITEM&);
+private:
+    int enumerate_where(
+        const char* where_clause, int nresult_limit,
+        std::vector<TRANSITIONER_ITEM>& items
+    );
+};
+
+// queues in the wu_queue table
+//
+#define WU_QUEUE_TRANSITIONER   0
+#define WU_QUEUE_VALIDATOR      1
+#define WU_QUEUE_ASSIMILATOR    2
+
+struct WU_QUEUE_ITEM {
+    DB_ID_TYPE id;
+    DB_ID_TYPE wuid;
+};
+
+// A queue of WUs that need attention from a daemon.
+// Programs that change a WU add it to the queue,
+// so that the daemon doesn't have to poll the workunit table.
+//
+class DB_WU_QUEUE : public DB_BASE_SPECIAL {
+public:
+    DB_WU_QUEUE(DB_CONN* p=0);
+    int add(int queue, DB_ID_TYPE wuid);
+    int add(int queue, std::vector<DB_ID_TYPE>& wuids);
+    int add_names(int queue, std::vector<std::string>& names);
+        // add the WUs with the given names
+        // (e.g. after a bulk insert, which doesn't give their IDs)
+    int get(
+        int queue, int limit, int mod_n, int mod_i,
+        std::vector<WU_QUEUE_ITEM>& items
+    );
+        // get the oldest items in the queue;
+        // if mod_n is nonzero, only those with (wuid mod mod_n) == mod_i
+    int remove(std::vector<WU_QUEUE_ITEM>& items);
 };
 
 // The validator uses this to get (WU, result) pairs efficiently.
@@ -427,9 +474,29 @@ public:
     int lookup_result(const char* result_name, SCHED_RESULT_ITEM** result);
 
     int update_result(SCHED_RESULT_ITEM& result);
+    int update_results(std::vector<SCHED_RESULT_ITEM*>& items);
+        // update several results with one SQL statement
     int update_workunits();
 };
 
+// Used by the scheduler to authenticate a request that has a host ID:
+// look up the host, its owner, and the owner's team with one query
+// rather than three.
+//
+class DB_HOST_USER_TEAM : public DB_BASE_SPECIAL {
+public:
+    DB_HOST_USER_TEAM(DB_CONN* p=0);
+    DB_HOST host;
+    DB_USER user;
+    DB_TEAM team;
+    bool have_user;
+        // false if host.userid doesn't refer to a user (e.g. zombie host)
+    bool have_team;
+
+    int lookup(DB_ID_TYPE hostid);
+        // ERR_DB_NOT_FOUND if no such host
+};
+
 struct FILE_ITEM {
     DB_ID_TYPE id;
     char name[254];
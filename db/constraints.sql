@@ -81,6 +81,10 @@ alter table msg_to_host
     add index msg_to_host(hostid, handled);
         -- for scheduler
 
+alter table wu_queue
+    add index wu_queue(queue, id);
+        -- for transitioner etc.
+
 alter table host
     add index host_userid_cpid (userid, host_cpid),
         -- html_user/host_user.php
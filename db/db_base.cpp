@@ -32,6 +32,7 @@ bool g_print_queries = false;
 
 DB_CONN::DB_CONN() {
     mysql = 0;
+    use_prepared = true;
 }
 
 int DB_CONN::open(
@@ -102,6 +103,11 @@ int DB_CONN::open(
 }
 
 void DB_CONN::close() {
+    std::map<std::string, DB_LOOKUP_STMT*>::iterator i;
+    for (i = lookup_stmts.begin(); i != lookup_stmts.end(); i++) {
+        delete i->second;
+    }
+    lookup_stmts.clear();
     if (mysql) mysql_close(mysql);
 }
 
@@ -167,6 +173,176 @@ DB_ID_TYPE DB_CONN::insert_id() {
     return x;
 }
 
+// initial size of column buffers; they grow as needed
+//
+#define LOOKUP_COL_BUF_SIZE 256
+
+DB_LOOKUP_STMT::DB_LOOKUP_STMT() {
+    stmt = NULL;
+    id = 0;
+}
+
+DB_LOOKUP_STMT::~DB_LOOKUP_STMT() {
+    if (stmt) mysql_stmt_close(stmt);
+}
+
+int DB_LOOKUP_STMT::init(MYSQL* mysql, const char* table_name) {
+    char query[256];
+    unsigned int i, ncols;
+
+    stmt = mysql_stmt_init(mysql);
+    if (!stmt) return ERR_DB_CANT_INIT;
+    snprintf(query, sizeof(query), "select * from %s where id=?", table_name);
+    if (mysql_stmt_prepare(stmt, query, strlen(query))) {
+        return mysql_stmt_errno(stmt);
+    }
+
+    memset(&param, 0, sizeof(param));
+    param.buffer_type = MYSQL_TYPE_LONGLONG;
+    param.buffer = &id;
+    if (mysql_stmt_bind_param(stmt, &param)) {
+        return mysql_stmt_errno(stmt);
+    }
+
+    MYSQL_RES* meta = mysql_stmt_result_metadata(stmt);
+    if (!meta) return mysql_stmt_errno(stmt);
+    ncols = mysql_num_fields(meta);
+    mysql_free_result(meta);
+
+    binds.resize(ncols);
+    cols.resize(ncols);
+    row.resize(ncols);
+    for (i=0; i<ncols; i++) {
+        // leave room for a NUL; MySQL doesn't always add one
+        //
+        cols[i].buf.resize(LOOKUP_COL_BUF_SIZE+1);
+        memset(&binds[i], 0, sizeof(MYSQL_BIND));
+        binds[i].buffer_type = MYSQL_TYPE_STRING;
+        binds[i].buffer = &cols[i].buf[0];
+        binds[i].buffer_length = LOOKUP_COL_BUF_SIZE;
+        binds[i].length = &cols[i].length;
+        binds[i].is_null = &cols[i].is_null;
+    }
+    if (mysql_stmt_bind_result(stmt, &binds[0])) {
+        return mysql_stmt_errno(stmt);
+    }
+    return 0;
+}
+
+// look up a row.
+// On success, row points to NUL-terminated strings (or NULL)
+// that are valid until the next call
+//
+int DB_LOOKUP_STMT::lookup(DB_ID_TYPE x, MYSQL_ROW& r) {
+    unsigned int i;
+    bool rebind = false;
+
+    id = x;
+    if (mysql_stmt_execute(stmt)) {
+        return mysql_stmt_errno(stmt);
+    }
+    int retval = mysql_stmt_fetch(stmt);
+    if (retval == MYSQL_NO_DATA) {
+        mysql_stmt_free_result(stmt);
+        return ERR_DB_NOT_FOUND;
+    }
+    if (retval == 1) {
+        retval = mysql_stmt_errno(stmt);
+        mysql_stmt_free_result(stmt);
+        return retval;
+    }
+
+    // if a column didn't fit, grow its buffer and fetch it again
+    //
+    for (i=0; i<cols.size(); i++) {
+        DB_LOOKUP_COL& col = cols[i];
+        if (!col.is_null && col.length > binds[i].buffer_length) {
+            col.buf.resize(col.length+1);
+            binds[i].buffer = &col.buf[0];
+            binds[i].buffer_length = col.length;
+            if (mysql_stmt_fetch_column(stmt, &binds[i], i, 0)) {
+                retval = mysql_stmt_errno(stmt);
+                mysql_stmt_free_result(stmt);
+                return retval;
+            }
+            rebind = true;
+        }
+    }
+    mysql_stmt_free_result(stmt);
+    if (rebind) {
+        if (mysql_stmt_bind_result(stmt, &binds[0])) {
+            return mysql_stmt_errno(stmt);
+        }
+    }
+
+    for (i=0; i<cols.size(); i++) {
+        DB_LOOKUP_COL& col = cols[i];
+        if (col.is_null) {
+            row[i] = NULL;
+        } else {
+            col.buf[col.length] = 0;
+            row[i] = &col.buf[0];
+        }
+    }
+    r = &row[0];
+    return 0;
+}
+
+// look up a row by ID using a prepared statement for the table.
+// Returns ERR_DB_NOT_FOUND if there's no such row;
+// other errors mean the caller should use a regular query.
+//
+int DB_CONN::lookup_id_prepared(
+    const char* table_name, DB_ID_TYPE id, MYSQL_ROW& row
+) {
+    DB_LOOKUP_STMT* sp;
+    int retval;
+
+    std::map<std::string, DB_LOOKUP_STMT*>::iterator i =
+        lookup_stmts.find(table_name);
+    if (i == lookup_stmts.end()) {
+        sp = new DB_LOOKUP_STMT;
+        retval = sp->init(mysql, table_name);
+        if (retval) {
+            boinc::fprintf(stderr,
+                "can't prepare lookup statement for %s: %s\n",
+                table_name, mysql_error(mysql)
+            );
+            delete sp;
+            sp = NULL;
+        }
+        lookup_stmts[table_name] = sp;
+    } else {
+        sp = i->second;
+    }
+    if (!sp) return ERR_NOT_IMPLEMENTED;
+
+    if (g_print_queries) {
+#ifdef _USING_FCGI_
+        log_messages.printf(MSG_NORMAL,
+            "prepared query: select * from %s where id=%lu\n", table_name, id
+        );
+#else
+        fprintf(stderr,
+            "prepared query: select * from %s where id=%lu\n", table_name, id
+        );
+#endif
+    }
+    retval = sp->lookup(id, row);
+    if (retval && retval != ERR_DB_NOT_FOUND) {
+        // e.g. the connection was reset, which discards prepared statements.
+        // Prepare a new one next time.
+        //
+        boinc::fprintf(stderr,
+            "prepared lookup in %s failed: %s\n",
+            table_name, mysql_stmt_error(sp->stmt)
+        );
+        delete sp;
+        lookup_stmts.erase(table_name);
+    }
+    return retval;
+}
+
 void DB_CONN::print_error(const char* p) {
     boinc::fprintf(stderr, "%s: Database error: %s\n", p, error_string());
 }
@@ -225,6 +401,16 @@ int DB_BASE::lookup_id(DB_ID_TYPE id) {
     MYSQL_ROW row;
     MYSQL_RES* rp;
 
+    if (db->use_prepared) {
+        retval = db->lookup_id_prepared(table_name, id, row);
+        if (retval == 0) {
+            db_parse(row);
+            return 0;
+        }
+        if (retval == ERR_DB_NOT_FOUND) return retval;
+        // else fall back to a regular query
+    }
+
     sprintf(query, "select * from %s where id=%lu", table_name, id);
 
     retval = db->do_query(query);
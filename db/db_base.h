@@ -19,7 +19,10 @@
 #define _DB_BASE_
 
 #include <cstdlib>
+#include <map>
 #include <string>
+#include <type_traits>
+#include <vector>
 #include <mysql.h>
 
 extern bool g_print_queries;
@@ -61,6 +64,36 @@ enum ISOLATION_LEVEL {
 
 typedef long DB_ID_TYPE;
 
+// the type MYSQL_BIND uses for NULL flags (my_bool in older versions)
+//
+typedef std::remove_pointer<decltype(MYSQL_BIND::is_null)>::type DB_BIND_BOOL;
+
+// A prepared statement "select * from T where id=?",
+// and buffers for the row it returns.
+// Avoids having MySQL parse the query each time.
+// Columns are fetched as strings,
+// so that the row can be passed to the table's db_parse().
+//
+struct DB_LOOKUP_COL {
+    std::vector<char> buf;
+    unsigned long length;
+    DB_BIND_BOOL is_null;
+};
+
+struct DB_LOOKUP_STMT {
+    MYSQL_STMT* stmt;
+    long long id;
+    MYSQL_BIND param;
+    std::vector<MYSQL_BIND> binds;
+    std::vector<DB_LOOKUP_COL> cols;
+    std::vector<char*> row;
+
+    DB_LOOKUP_STMT();
+    ~DB_LOOKUP_STMT();
+    int init(MYSQL*, const char* table_name);
+    int lookup(DB_ID_TYPE, MYSQL_ROW&);
+};
+
 // represents a connection to a database
 //
 class DB_CONN {
@@ -79,8 +112,14 @@ public:
     int rollback_transaction();
     int commit_transaction();
     int get_double(const char* query, double&);
+    int lookup_id_prepared(const char* table_name, DB_ID_TYPE, MYSQL_ROW&);
 
     MYSQL* mysql;
+    bool use_prepared;
+        // use prepared statements for lookup_id()
+    std::map<std::string, DB_LOOKUP_STMT*> lookup_stmts;
+        // prepared statements, by table name.
+        // NULL if we couldn't prepare one for that table
 };
 
 // Base for derived classes that can access the DB
@@ -411,6 +411,17 @@ create table msg_to_host (
     primary key (id)
 ) engine=InnoDB;
 
+-- WUs that need attention from a daemon (transitioner, validator, assimilator).
+-- Used if <wu_queue> is set in config.xml;
+-- the daemon handles the queued WUs and deletes the rows.
+--
+create table wu_queue (
+    id                      bigint          not null auto_increment,
+    queue                   smallint        not null,
+    wuid                    bigint          not null,
+    primary key (id)
+) engine=InnoDB;
+
 -- An assignment of a WU to a specific host, user, or team, or to all hosts
 --
 create table assignment (
@@ -1283,6 +1283,17 @@ function update_5_2_2026b() {
     do_query("alter table consent_type CONVERT TO CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci");
 }
 
+function update_10_18_2026() {
+    do_query("create table wu_queue (
+        id                      bigint          not null auto_increment,
+        queue                   smallint        not null,
+        wuid                    bigint          not null,
+        primary key (id)
+        ) engine=InnoDB"
+    );
+    do_query("alter table wu_queue add index wu_queue(queue, id)");
+}
+
 // Updates are done automatically if you use "upgrade".
 //
 // If you need to do updates manually,
@@ -1347,6 +1358,7 @@ $db_updates = array (
     array(27030, "update_11_23_2025"),
     array(27031, "update_5_2_2026a"),
     array(27032, "update_5_2_2026b"),
+    array(27033, "update_10_18_2026"),
 );
 
 ?>
@@ -328,10 +328,16 @@ void strip_whitespace(string& str) {
     str.erase(n, str.length()-n);
 }
 
+// in place; XML_PARSER calls this for every tag and value,
+// so don't copy to a string
+//
 void strip_whitespace(char *str) {
-    string s = str;
-    strip_whitespace(s);
-    strcpy(str, s.c_str());
+    char* p = str;
+    while (*p && isascii(*p) && isspace(*p)) p++;
+    size_t n = strlen(p);
+    while (n>0 && isascii(p[n-1]) && isspace(p[n-1])) n--;
+    if (p != str) memmove(str, p, n);
+    str[n] = 0;
 }
 
 // remove whitespace and quotes from start and end of a string
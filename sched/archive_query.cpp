@@ -0,0 +1,339 @@
+// This file is part of BOINC.
+// https://boinc.berkeley.edu
+// Copyright (C) 2026 University of California
+//
+// BOINC is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+// BOINC is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with BOINC.  If not, see <http://www.gnu.org/licenses/>.
+
+// archive_query [options] file ...
+//
+// Scan columnar archive files written by db_purge --columnar,
+// and print matching rows as tab-separated text.
+// Doesn't need a project or DB.
+//
+// options:
+//  --cols a,b,c        print only these columns (default: all)
+//  --where EXPR        print only rows where EXPR is true.
+//                      EXPR is "column OP value",
+//                      where OP is =, !=, <, <=, >, or >=
+//                      (only = and != for string columns).
+//                      Can be given more than once.
+//  --min_id N          same as --where "id>=N"
+//  --max_id N          same as --where "id<=N"
+//  --count             print only the number of matching rows
+//  --verbose           show how many blocks were read and skipped
+//
+// Conditions on numeric columns are checked against the min and max
+// stored in each block header,
+// so blocks that can't match are skipped without being decompressed.
+
+#include "config.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "error_numbers.h"
+#include "str_util.h"
+
+#include "col_archive.h"
+
+using std::string;
+using std::vector;
+
+#define OP_EQ   0
+#define OP_NE   1
+#define OP_LT   2
+#define OP_LE   3
+#define OP_GT   4
+#define OP_GE   5
+
+struct PREDICATE {
+    string col;
+    int op;
+    string value;
+    int icol;
+        // index of column in the current file
+    int64_t ival;
+    double dval;
+};
+
+vector<PREDICATE> preds;
+vector<string> out_cols;
+bool count_only = false;
+bool verbose = false;
+
+long nblocks_read=0, nblocks_skipped=0, nrows_matched=0;
+
+void usage() {
+    fprintf(stderr,
+        "usage: archive_query [--cols a,b,c] [--where EXPR] [--min_id N] [--max_id N]\n"
+        "           [--count] [--verbose] file ...\n"
+    );
+    exit(1);
+}
+
+void parse_where(const char* expr) {
+    PREDICATE p;
+    const char* q = strpbrk(expr, "=!<>");
+    if (!q || q == expr) usage();
+    p.col = string(expr, q-expr);
+    strip_whitespace(p.col);
+    if (!strncmp(q, "!=", 2)) {
+        p.op = OP_NE; q += 2;
+    } else if (!strncmp(q, "<=", 2)) {
+        p.op = OP_LE; q += 2;
+    } else if (!strncmp(q, ">=", 2)) {
+        p.op = OP_GE; q += 2;
+    } else if (*q == '=') {
+        p.op = OP_EQ; q++;
+    } else if (*q == '<') {
+        p.op = OP_LT; q++;
+    } else if (*q == '>') {
+        p.op = OP_GT; q++;
+    } else {
+        usage();
+    }
+    p.value = q;
+    strip_whitespace(p.value);
+    p.ival = strtoll(p.value.c_str(), NULL, 10);
+    p.dval = atof(p.value.c_str());
+    p.icol = -1;
+    preds.push_back(p);
+}
+
+template <class T> bool compare(T x, int op, T y) {
+    switch (op) {
+    case OP_EQ: return x == y;
+    case OP_NE: return x != y;
+    case OP_LT: return x < y;
+    case OP_LE: return x <= y;
+    case OP_GT: return x > y;
+    case OP_GE: return x >= y;
+    }
+    return false;
+}
+
+// can any value in [min, max] satisfy the predicate?
+//
+bool range_can_match(PREDICATE& p, COL_ARCHIVE_RANGE& r) {
+    switch (p.op) {
+    case OP_EQ: return r.min <= p.dval && p.dval <= r.max;
+    case OP_NE: return !(r.min == p.dval && r.max == p.dval);
+    case OP_LT: return r.min < p.dval;
+    case OP_LE: return r.min <= p.dval;
+    case OP_GT: return r.max > p.dval;
+    case OP_GE: return r.max >= p.dval;
+    }
+    return true;
+}
+
+bool row_matches(
+    COL_ARCHIVE_READER& reader, vector<COL_ARCHIVE_VALUES>& vals, int row
+) {
+    for (unsigned int i=0; i<preds.size(); i++) {
+        PREDICATE& p = preds[i];
+        COL_ARCHIVE_VALUES& v = vals[p.icol];
+        switch (reader.cols[p.icol].type) {
+        case COL_INT:
+        case COL_ID:
+            if (!compare(v.ivals[row], p.op, p.ival)) return false;
+            break;
+        case COL_DOUBLE:
+            if (!compare(v.dvals[row], p.op, p.dval)) return false;
+            break;
+        case COL_STRING:
+            if (!compare(v.svals[row], p.op, p.value)) return false;
+            break;
+        }
+    }
+    return true;
+}
+
+// print a string, escaping characters that would break the TSV format
+//
+void print_escaped(const string& s) {
+    for (unsigned int i=0; i<s.size(); i++) {
+        switch (s[i]) {
+        case '\t': fputs("\\t", stdout); break;
+        case '\n': fputs("\\n", stdout); break;
+        case '\r': fputs("\\r", stdout); break;
+        case '\\': fputs("\\\\", stdout); break;
+        default: putchar(s[i]);
+        }
+    }
+}
+
+void print_row(
+    COL_ARCHIVE_READER& reader, vector<COL_ARCHIVE_VALUES>& vals,
+    vector<int>& icols, int row
+) {
+    for (unsigned int i=0; i<icols.size(); i++) {
+        int j = icols[i];
+        if (i) putchar('\t');
+        switch (reader.cols[j].type) {
+        case COL_INT:
+        case COL_ID:
+            printf("%lld", (long long)vals[j].ivals[row]);
+            break;
+        case COL_DOUBLE:
+            printf("%.15g", vals[j].dvals[row]);
+            break;
+        case COL_STRING:
+            print_escaped(vals[j].svals[row]);
+            break;
+        }
+    }
+    putchar('\n');
+}
+
+int scan_file(const char* path, bool print_header) {
+    COL_ARCHIVE_READER reader;
+    COL_ARCHIVE_BLOCK_HEADER bh;
+    vector<COL_ARCHIVE_VALUES> vals;
+    vector<int> icols;
+    int retval;
+
+    retval = reader.open(path);
+    if (retval) {
+        fprintf(stderr, "%s: can't open, or not a columnar archive\n", path);
+        return retval;
+    }
+    for (unsigned int i=0; i<preds.size(); i++) {
+        PREDICATE& p = preds[i];
+        p.icol = reader.col_index(p.col.c_str());
+        if (p.icol < 0) {
+            fprintf(stderr, "%s: no column %s\n", path, p.col.c_str());
+            return ERR_NOT_FOUND;
+        }
+        if (reader.cols[p.icol].type == COL_STRING
+            && p.op != OP_EQ && p.op != OP_NE
+        ) {
+            fprintf(stderr, "%s is a string column; use = or !=\n",
+                p.col.c_str()
+            );
+            return ERR_BAD_FORMAT;
+        }
+    }
+    if (out_cols.empty()) {
+        for (unsigned int i=0; i<reader.cols.size(); i++) {
+            icols.push_back(i);
+        }
+    } else {
+        for (unsigned int i=0; i<out_cols.size(); i++) {
+            int j = reader.col_index(out_cols[i].c_str());
+            if (j < 0) {
+                fprintf(stderr, "%s: no column %s\n", path, out_cols[i].c_str());
+                return ERR_NOT_FOUND;
+            }
+            icols.push_back(j);
+        }
+    }
+    if (print_header && !count_only) {
+        for (unsigned int i=0; i<icols.size(); i++) {
+            printf("%s%s", i?"\t":"", reader.cols[icols[i]].name.c_str());
+        }
+        printf("\n");
+    }
+
+    while (1) {
+        retval = reader.read_block_header(bh);
+        if (retval == ERR_NOT_FOUND) break;
+        if (retval) {
+            fprintf(stderr, "%s: truncated block header\n", path);
+            return retval;
+        }
+
+        bool skip = false;
+        for (unsigned int i=0; i<preds.size(); i++) {
+            PREDICATE& p = preds[i];
+            if (reader.cols[p.icol].type == COL_STRING) continue;
+            if (!range_can_match(p, bh.ranges[p.icol])) {
+                skip = true;
+                break;
+            }
+        }
+        if (skip) {
+            nblocks_skipped++;
+            retval = reader.skip_block(bh);
+            if (retval) return retval;
+            continue;
+        }
+
+        nblocks_read++;
+        retval = reader.read_block(bh, vals);
+        if (retval) {
+            fprintf(stderr, "%s: bad block\n", path);
+            return retval;
+        }
+        for (unsigned int row=0; row<bh.nrows; row++) {
+            if (!row_matches(reader, vals, row)) continue;
+            nrows_matched++;
+            if (!count_only) {
+                print_row(reader, vals, icols, row);
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    vector<const char*> files;
+    char buf[256];
+
+    for (int i=1; i<argc; i++) {
+        if (!strcmp(argv[i], "--cols")) {
+            if (++i >= argc) usage();
+            char* p = strtok(argv[i], ",");
+            while (p) {
+                out_cols.push_back(p);
+                p = strtok(NULL, ",");
+            }
+        } else if (!strcmp(argv[i], "--where")) {
+            if (++i >= argc) usage();
+            parse_where(argv[i]);
+        } else if (!strcmp(argv[i], "--min_id")) {
+            if (++i >= argc) usage();
+            snprintf(buf, sizeof(buf), "id>=%s", argv[i]);
+            parse_where(buf);
+        } else if (!strcmp(argv[i], "--max_id")) {
+            if (++i >= argc) usage();
+            snprintf(buf, sizeof(buf), "id<=%s", argv[i]);
+            parse_where(buf);
+        } else if (!strcmp(argv[i], "--count")) {
+            count_only = true;
+        } else if (!strcmp(argv[i], "--verbose")) {
+            verbose = true;
+        } else if (argv[i][0] == '-') {
+            usage();
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty()) usage();
+
+    int status = 0;
+    for (unsigned int i=0; i<files.size(); i++) {
+        if (scan_file(files[i], i==0)) status = 1;
+    }
+    if (count_only) {
+        printf("%ld\n", nrows_matched);
+    }
+    if (verbose) {
+        fprintf(stderr, "%ld blocks read, %ld skipped, %ld rows matched\n",
+            nblocks_read, nblocks_skipped, nrows_matched
+        );
+    }
+    return status;
+}
@@ -20,11 +20,16 @@
 // See https://github.com/BOINC/boinc/wiki/AssimilateIntro
 
 #include "config.h"
+#include <cerrno>
+#include <csignal>
 #include <cstring>
 #include <cstdlib>
 #include <unistd.h>
 #include <ctime>
+#include <map>
+#include <string>
 #include <vector>
+#include <sys/wait.h>
 
 #include "boinc_db.h"
 #include "parse.h"
@@ -40,15 +45,75 @@
 #include "assimilate_handler.h"
 
 using std::vector;
+using std::map;
+using std::string;
 
 #define LOCKFILE "assimilator.out"
 #define PIDFILE  "assimilator.pid"
 #define SLEEP_INTERVAL 10
+#define DEFAULT_BATCH_SIZE 20
+    // WUs per result query and state update.
+    // Each WU's results are in memory, so don't make this too big.
 
 bool update_db = true;
 int wu_id_modulus=0, wu_id_remainder=0;
 int sleep_interval = SLEEP_INTERVAL;
 int one_pass_N_WU=0;
+int batch_size = DEFAULT_BATCH_SIZE;
+int nprocs = 1;
+
+// with --nprocs, the parent's child processes (0 once reaped)
+//
+std::vector<pid_t> child_pids;
+volatile sig_atomic_t parent_stopping = 0;
+
+// pass the stop signal (from bin/stop) on to the children
+//
+static void parent_stop_signal_handler(int) {
+    parent_stopping = 1;
+    for (pid_t pid: child_pids) {
+        if (pid) kill(pid, SIGHUP);
+    }
+}
+
+// Wait for the child processes, and exit.
+// Without --one_pass they run until stopped.
+// If one exits anyway (e.g. it lost its DB connection)
+// its WUs would no longer be assimilated,
+// so stop the others and exit with an error;
+// "start --cron" then restarts the group.
+//
+static void wait_for_children(bool one_pass) {
+    int status, nleft = (int)child_pids.size();
+    bool failed = false;
+
+    signal(SIGHUP, parent_stop_signal_handler);
+    while (nleft) {
+        pid_t pid = wait(&status);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        nleft--;
+        for (pid_t& p: child_pids) {
+            if (p == pid) p = 0;
+        }
+        if (!WIFEXITED(status) || WEXITSTATUS(status)) failed = true;
+        if (one_pass || parent_stopping) continue;
+
+        // exits if the stop trigger file is present;
+        // the other children will stop too
+        //
+        check_stop_daemons();
+
+        log_messages.printf(MSG_CRITICAL,
+            "process %d exited; stopping the others\n", (int)pid
+        );
+        failed = true;
+        parent_stop_signal_handler(0);
+    }
+    exit(failed?1:0);
+}
 
 void usage(char* name) {
     fprintf(stderr,
@@ -64,6 +129,8 @@ void usage(char* name) {
         "    [--mod N R]           Process jobs with mod(ID, N) == R\n"
         "    [--one_pass]          Do one DB enumeration, then exit\n"
         "    [--one_pass_N_WU N]   Process at most N jobs\n"
+        "    [--batch_size N]      Handle N jobs per DB query/update (default 20)\n"
+        "    [--nprocs N]          Run N processes, each handling a subset of jobs\n"
         "    [-d | --debug_level N]       Set verbosity level (1 to 4)\n"
         "    [--dont_update_db]    Don't update BOINC DB (for testing)\n"
         "    [-h | --help]                 Show this\n"
@@ -74,33 +141,81 @@ void usage(char* name) {
     assimilate_handler_usage();
 }
 
-// assimilate all WUs that need it
-// return nonzero (true) if did anything
+// set assimilate_state of a batch of WUs, in one transaction
 //
-bool do_pass(APP& app) {
+void update_assimilate_states(
+    vector<DB_ID_TYPE>& done_ids, vector<DB_ID_TYPE>& deferred_ids
+) {
     DB_WORKUNIT wu;
-    DB_RESULT canonical_result, result;
-    bool did_something = false;
-    char buf[256];
-    char mod_clause[256];
-    int retval;
-    int num_assimilated=0;
+    char set_clause[256];
+    string where;
+    char buf[64];
+    int retval = 0;
 
-    if (wu_id_modulus) {
-        sprintf(mod_clause, " and workunit.id %% %d = %d ",
-                wu_id_modulus, wu_id_remainder
+    if (!update_db) return;
+    if (done_ids.empty() && deferred_ids.empty()) return;
+
+    boinc_db.start_transaction();
+    for (int i=0; i<2 && !retval; i++) {
+        // Defer assimilation until next result is returned
+        //
+        vector<DB_ID_TYPE>& ids = i?deferred_ids:done_ids;
+        if (ids.empty()) continue;
+        sprintf(set_clause, "assimilate_state=%d, transition_time=%d",
+            i?ASSIMILATE_INIT:ASSIMILATE_DONE, (int)time(0)
         );
-    } else {
-        strcpy(mod_clause, "");
+        where = "id in (";
+        for (unsigned int j=0; j<ids.size(); j++) {
+            sprintf(buf, j?",%lu":"%lu", ids[j]);
+            where += buf;
+        }
+        where += ")";
+        retval = wu.update_fields_noid(set_clause, where.c_str());
     }
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "update of %d WUs failed: %s\n",
+            (int)(done_ids.size() + deferred_ids.size()), boincerror(retval)
+        );
+        boinc_db.rollback_transaction();
+        exit(1);
+    }
+    if (config.wu_queue) {
+        DB_WU_QUEUE wu_queue;
+        retval = wu_queue.add(WU_QUEUE_TRANSITIONER, done_ids);
+        if (!retval) retval = wu_queue.add(WU_QUEUE_TRANSITIONER, deferred_ids);
+        if (retval) {
+            log_messages.printf(MSG_CRITICAL,
+                "can't queue WUs for transitioner: %s\n", boincerror(retval)
+            );
+        }
+    }
+    boinc_db.commit_transaction();
+    done_ids.clear();
+    deferred_ids.clear();
+}
 
-    sprintf(buf,
-        "where appid=%ld and assimilate_state=%d %s limit %d",
-        app.id, ASSIMILATE_READY, mod_clause,
-        one_pass_N_WU ? one_pass_N_WU : 1000
-    );
+// assimilate a batch of WUs.
+// Get their results with one query,
+// and update their states in one transaction.
+//
+void assimilate_batch(vector<DB_WORKUNIT>& wus) {
+    DB_RESULT result;
+    RESULT canonical_result;
+    map<DB_ID_TYPE, vector<RESULT> > results;
+    vector<DB_ID_TYPE> done_ids, deferred_ids;
+    string clause;
+    char buf[256];
+    int retval;
+
+    clause = "where workunitid in (";
+    for (unsigned int i=0; i<wus.size(); i++) {
+        sprintf(buf, i?",%lu":"%lu", wus[i].id);
+        clause += buf;
+    }
+    clause += ")";
     while (1) {
-        retval = wu.enumerate(buf);
+        retval = result.enumerate(clause.c_str());
         if (retval) {
             if (retval != ERR_DB_NOT_FOUND) {
                 log_messages.printf(MSG_DEBUG,
@@ -110,35 +225,22 @@ bool do_pass(APP& app) {
             }
             break;
         }
-        vector<RESULT> results;     // must be inside while()!
+        results[result.workunitid].push_back(result);
+    }
 
-        // for testing purposes, pretend we did nothing
-        //
-        if (update_db) {
-            did_something = true;
-        }
+    for (unsigned int i=0; i<wus.size(); i++) {
+        DB_WORKUNIT& wu = wus[i];
+        vector<RESULT>& wu_results = results[wu.id];
 
         log_messages.printf(MSG_DEBUG,
             "[%s] assimilating WU %lu; state=%d\n", wu.name, wu.id, wu.assimilate_state
         );
 
-        sprintf(buf, "where workunitid=%ld", wu.id);
         canonical_result.clear();
         bool found = false;
-        while (1) {
-            retval = result.enumerate(buf);
-            if (retval) {
-                if (retval != ERR_DB_NOT_FOUND) {
-                    log_messages.printf(MSG_DEBUG,
-                        "DB connection lost, exiting\n"
-                    );
-                    exit(0);
-                }
-                break;
-            }
-            results.push_back(result);
-            if (result.id == wu.canonical_resultid) {
-                canonical_result = result;
+        for (unsigned int j=0; j<wu_results.size(); j++) {
+            if (wu_results[j].id == wu.canonical_resultid) {
+                canonical_result = wu_results[j];
                 found = true;
             }
         }
@@ -157,40 +259,78 @@ bool do_pass(APP& app) {
             wu.update_field(buf);
         }
 
-        retval = assimilate_handler(wu, results, canonical_result);
+        retval = assimilate_handler(wu, wu_results, canonical_result);
         if (retval && retval != DEFER_ASSIMILATION) {
             log_messages.printf(MSG_CRITICAL,
                 "assimilator.cpp [%s] handler error %d: %s; exiting\n",
                 wu.name, retval, boincerror(retval)
             );
+            // record the WUs we've already done
+            //
+            update_assimilate_states(done_ids, deferred_ids);
             exit(retval);
         }
+        if (retval == DEFER_ASSIMILATION) {
+            deferred_ids.push_back(wu.id);
+        } else {
+            done_ids.push_back(wu.id);
+        }
+    }
+    update_assimilate_states(done_ids, deferred_ids);
+}
 
-        if (update_db) {
-            // Defer assimilation until next result is returned
-            int assimilate_state = ASSIMILATE_DONE;
-            if (retval == DEFER_ASSIMILATION) {
-                assimilate_state = ASSIMILATE_INIT;
-            }
-            sprintf(
-                buf, "assimilate_state=%d, transition_time=%d",
-                assimilate_state, (int)time(0)
-            );
-            retval = wu.update_field(buf);
-            if (retval) {
-                log_messages.printf(MSG_CRITICAL,
-                    "[%s] update failed: %s\n", wu.name, boincerror(retval)
+// assimilate all WUs that need it
+// return nonzero (true) if did anything
+//
+bool do_pass(APP& app) {
+    DB_WORKUNIT wu;
+    vector<DB_WORKUNIT> wus;
+    bool did_something = false;
+    char buf[256];
+    char mod_clause[256];
+    int retval;
+    int num_assimilated=0;
+
+    if (wu_id_modulus) {
+        sprintf(mod_clause, " and workunit.id %% %d = %d ",
+                wu_id_modulus, wu_id_remainder
+        );
+    } else {
+        strcpy(mod_clause, "");
+    }
+
+    sprintf(buf,
+        "where appid=%ld and assimilate_state=%d %s limit %d",
+        app.id, ASSIMILATE_READY, mod_clause,
+        one_pass_N_WU ? one_pass_N_WU : 1000
+    );
+    while (1) {
+        retval = wu.enumerate(buf);
+        if (retval) {
+            if (retval != ERR_DB_NOT_FOUND) {
+                log_messages.printf(MSG_DEBUG,
+                    "DB connection lost, exiting\n"
                 );
-                exit(1);
+                exit(0);
             }
+            break;
         }
 
-        num_assimilated++;
+        // for testing purposes, pretend we did nothing
+        //
+        if (update_db) {
+            did_something = true;
+        }
 
+        wus.push_back(wu);
+        if ((int)wus.size() < batch_size) continue;
+        assimilate_batch(wus);
+        num_assimilated += (int)wus.size();
+        wus.clear();
     }
-
-    if (did_something) {
-        boinc_db.commit_transaction();
+    if (!wus.empty()) {
+        assimilate_batch(wus);
+        num_assimilated += (int)wus.size();
     }
 
     if (num_assimilated)  {
@@ -234,6 +374,19 @@ int main(int argc, char** argv) {
                 exit(1);
             }
             sleep_interval = atoi(argv[i]);
+        } else if (is_arg(argv[i], "batch_size")) {
+            if (!argv[++i]) {
+                missing_argument(argv[0], argv[--i]);
+                exit(1);
+            }
+            batch_size = atoi(argv[i]);
+            if (batch_size < 1) batch_size = 1;
+        } else if (is_arg(argv[i], "nprocs")) {
+            if (!argv[++i]) {
+                missing_argument(argv[0], argv[--i]);
+                exit(1);
+            }
+            nprocs = atoi(argv[i]);
         } else if (is_arg(argv[i], "one_pass")) {
             one_pass = true;
         } else if (is_arg(argv[i], "d") || is_arg(argv[i], "debug_level")) {
@@ -285,13 +438,6 @@ int main(int argc, char** argv) {
         exit(1);
     }
 
-    if (wu_id_modulus) {
-        log_messages.printf(MSG_DEBUG,
-            "Using mod'ed WU enumeration.  modulus = %d  remainder = %d\n",
-            wu_id_modulus, wu_id_remainder
-        );
-    }
-
     retval = config.parse_file();
     if (retval) {
         log_messages.printf(MSG_CRITICAL,
@@ -300,6 +446,46 @@ int main(int argc, char** argv) {
         exit(1);
     }
 
+    // if --nprocs, fork processes that each handle a subset of WUs
+    // (by ID, within the --mod subset if any),
+    // with their own DB connection and handler state.
+    //
+    if (nprocs > 1) {
+        int modulus = wu_id_modulus?wu_id_modulus:1;
+        int remainder = wu_id_remainder;
+        bool is_child = false;
+        if (one_pass_N_WU) {
+            one_pass_N_WU = (one_pass_N_WU + nprocs - 1)/nprocs;
+        }
+        for (i=0; i<nprocs; i++) {
+            pid_t pid = fork();
+            if (pid < 0) {
+                log_messages.printf(MSG_CRITICAL, "fork() failed\n");
+                parent_stop_signal_handler(0);
+                exit(1);
+            }
+            if (pid == 0) {
+                wu_id_modulus = modulus*nprocs;
+                wu_id_remainder = remainder + i*modulus;
+                log_messages.pid = getpid();
+                child_pids.clear();
+                is_child = true;
+                break;
+            }
+            child_pids.push_back(pid);
+        }
+        if (!is_child) {
+            wait_for_children(one_pass);
+        }
+    }
+
+    if (wu_id_modulus) {
+        log_messages.printf(MSG_DEBUG,
+            "Using mod'ed WU enumeration.  modulus = %d  remainder = %d\n",
+            wu_id_modulus, wu_id_remainder
+        );
+    }
+
     retval = boinc_db.open(config.db_name, config.db_host, config.db_user, config.db_passwd);
     if (retval) {
         log_messages.printf(MSG_CRITICAL, "boinc_db.open failed: %s\n",
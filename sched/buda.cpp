@@ -19,6 +19,9 @@
 // parse BUDA app and variant description files
 
 
+#include <ctime>
+#include <sys/stat.h>
+
 #include <nlohmann/json.hpp>
 using nlohmann::json;
 
@@ -135,6 +138,7 @@ bool BUDA_APP::read_json() {
 }
 
 void BUDA_APPS::read_json() {
+    apps.clear();
     DirScanner ds(BUDA_APPS_DIR);
     string name;
     while (ds.scan(name)) {
@@ -282,8 +286,55 @@ void set_have_apps_flags() {
     }
 }
 
+static void update_mtime(const char* path, time_t& t) {
+    struct stat sb;
+    if (stat(path, &sb)) return;
+    if (sb.st_mtime > t) t = sb.st_mtime;
+}
+
+// the latest modification time of the app descriptions:
+// the buda_apps dir, the app dirs, and the files and variant dirs in them.
+// (buda.php writes desc.json in place,
+// and replaces a variant by deleting and recreating its dir)
+//
+static time_t buda_apps_mtime() {
+    char path[MAXPATHLEN], path2[MAXPATHLEN];
+    string app_name, name;
+    time_t t = 0;
+
+    update_mtime(BUDA_APPS_DIR, t);
+    DirScanner ds(BUDA_APPS_DIR);
+    while (ds.scan(app_name)) {
+        snprintf(path, sizeof(path), "%s/%s", BUDA_APPS_DIR, app_name.c_str());
+        update_mtime(path, t);
+        DirScanner ds2(path);
+        while (ds2.scan(name)) {
+            snprintf(path2, sizeof(path2), "%s/%s", path, name.c_str());
+            update_mtime(path2, t);
+        }
+    }
+    return t;
+}
+
+// Called at the start of each request.
+// The app descriptions are read once per process
+// (under FCGI, a process handles many requests),
+// and again if they've changed since then.
+// The have-apps flags are set each time,
+// since the feeder clears them when it rereads the DB.
+//
 void buda_init() {
-    buda_apps.read_json();
+    static time_t read_time = 0, read_mtime = 0;
+    time_t t = buda_apps_mtime();
+
+    // mtimes are in seconds, so a change in the second of the last read
+    // might not have been seen; read again in that case
+    //
+    if (t != read_mtime || t >= read_time) {
+        buda_apps.read_json();
+        read_mtime = t;
+        read_time = time(0);
+    }
     set_have_apps_flags();
 }
 
@@ -0,0 +1,468 @@
+// This file is part of BOINC.
+// https://boinc.berkeley.edu
+// Copyright (C) 2026 University of California
+//
+// BOINC is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+// BOINC is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with BOINC.  If not, see <http://www.gnu.org/licenses/>.
+
+// Reading and writing columnar archive files; see col_archive.h
+
+#include "config.h"
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include "zlib.h"
+
+#include "boinc_db_types.h"
+#include "error_numbers.h"
+
+#include "col_archive.h"
+
+using std::string;
+using std::vector;
+using std::map;
+
+#define WU_COL(field, type) \
+    {#field, type, offsetof(WORKUNIT, field), sizeof(((WORKUNIT*)0)->field)}
+#define RESULT_COL(field, type) \
+    {#field, type, offsetof(RESULT, field), sizeof(((RESULT*)0)->field)}
+
+// the same fields as in the XML archives
+//
+COL_ARCHIVE_COLUMN wu_archive_columns[] = {
+    WU_COL(id, COL_ID),
+    WU_COL(create_time, COL_INT),
+    WU_COL(appid, COL_ID),
+    WU_COL(name, COL_STRING),
+    WU_COL(xml_doc, COL_STRING),
+    WU_COL(batch, COL_INT),
+    WU_COL(rsc_fpops_est, COL_DOUBLE),
+    WU_COL(rsc_fpops_bound, COL_DOUBLE),
+    WU_COL(rsc_memory_bound, COL_DOUBLE),
+    WU_COL(rsc_disk_bound, COL_DOUBLE),
+    WU_COL(need_validate, COL_INT),
+    WU_COL(canonical_resultid, COL_ID),
+    WU_COL(canonical_credit, COL_DOUBLE),
+    WU_COL(transition_time, COL_INT),
+    WU_COL(delay_bound, COL_INT),
+    WU_COL(error_mask, COL_INT),
+    WU_COL(file_delete_state, COL_INT),
+    WU_COL(assimilate_state, COL_INT),
+    WU_COL(hr_class, COL_INT),
+    WU_COL(opaque, COL_DOUBLE),
+    WU_COL(min_quorum, COL_INT),
+    WU_COL(target_nresults, COL_INT),
+    WU_COL(max_error_results, COL_INT),
+    WU_COL(max_total_results, COL_INT),
+    WU_COL(max_success_results, COL_INT),
+    WU_COL(result_template_file, COL_STRING),
+    WU_COL(priority, COL_INT),
+    WU_COL(mod_time, COL_STRING),
+};
+int n_wu_archive_columns =
+    sizeof(wu_archive_columns)/sizeof(COL_ARCHIVE_COLUMN);
+
+COL_ARCHIVE_COLUMN result_archive_columns[] = {
+    RESULT_COL(id, COL_ID),
+    RESULT_COL(create_time, COL_INT),
+    RESULT_COL(workunitid, COL_ID),
+    RESULT_COL(server_state, COL_INT),
+    RESULT_COL(outcome, COL_INT),
+    RESULT_COL(client_state, COL_INT),
+    RESULT_COL(hostid, COL_ID),
+    RESULT_COL(userid, COL_ID),
+    RESULT_COL(report_deadline, COL_INT),
+    RESULT_COL(sent_time, COL_INT),
+    RESULT_COL(received_time, COL_INT),
+    RESULT_COL(name, COL_STRING),
+    RESULT_COL(cpu_time, COL_DOUBLE),
+    RESULT_COL(xml_doc_in, COL_STRING),
+    RESULT_COL(xml_doc_out, COL_STRING),
+    RESULT_COL(stderr_out, COL_STRING),
+    RESULT_COL(batch, COL_INT),
+    RESULT_COL(file_delete_state, COL_INT),
+    RESULT_COL(validate_state, COL_INT),
+    RESULT_COL(claimed_credit, COL_DOUBLE),
+    RESULT_COL(granted_credit, COL_DOUBLE),
+    RESULT_COL(opaque, COL_DOUBLE),
+    RESULT_COL(random, COL_INT),
+    RESULT_COL(app_version_num, COL_INT),
+    RESULT_COL(app_version_id, COL_ID),
+    RESULT_COL(appid, COL_ID),
+    RESULT_COL(exit_status, COL_INT),
+    RESULT_COL(teamid, COL_ID),
+    RESULT_COL(priority, COL_INT),
+    RESULT_COL(mod_time, COL_STRING),
+};
+int n_result_archive_columns =
+    sizeof(result_archive_columns)/sizeof(COL_ARCHIVE_COLUMN);
+
+static inline void put(string& buf, const void* p, size_t n) {
+    buf.append((const char*)p, n);
+}
+
+static inline void put_u32(string& buf, uint32_t x) {
+    put(buf, &x, sizeof(x));
+}
+
+// sequential reads from a buffer, with bounds checking
+//
+struct BUF_READER {
+    const char* p;
+    size_t left;
+
+    BUF_READER(const char* _p, size_t n): p(_p), left(n) {}
+    bool get(void* dst, size_t n) {
+        if (n > left) return false;
+        memcpy(dst, p, n);
+        p += n;
+        left -= n;
+        return true;
+    }
+    bool get_u32(uint32_t& x) {
+        return get(&x, sizeof(x));
+    }
+    bool get_string(string& s, size_t n) {
+        if (n > left) return false;
+        s.assign(p, n);
+        p += n;
+        left -= n;
+        return true;
+    }
+};
+
+////////////// writer ////////////////
+
+int COL_ARCHIVE_WRITER::open(
+    const char* path, COL_ARCHIVE_COLUMN* _cols, int _ncols
+) {
+    cols = _cols;
+    ncols = _ncols;
+    vals.clear();
+    vals.resize(ncols);
+    nrows = 0;
+    raw_size = 0;
+
+    f = fopen(path, "w");
+    if (!f) return ERR_FOPEN;
+
+    string buf;
+    put(buf, COL_ARCHIVE_MAGIC, strlen(COL_ARCHIVE_MAGIC));
+    put_u32(buf, COL_ARCHIVE_BYTE_ORDER);
+    put_u32(buf, ncols);
+    for (int i=0; i<ncols; i++) {
+        unsigned char type = cols[i].type;
+        unsigned char len = strlen(cols[i].name);
+        put(buf, &type, 1);
+        put(buf, &len, 1);
+        put(buf, cols[i].name, len);
+    }
+    if (fwrite(buf.data(), 1, buf.size(), f) != buf.size()) {
+        fclose(f);
+        f = NULL;
+        return ERR_FWRITE;
+    }
+    return 0;
+}
+
+void COL_ARCHIVE_WRITER::add_row(void* rec) {
+    for (int i=0; i<ncols; i++) {
+        COL_ARCHIVE_COLUMN& c = cols[i];
+        COL_ARCHIVE_VALUES& v = vals[i];
+        const char* p = (const char*)rec + c.offset;
+        switch (c.type) {
+        case COL_INT:
+            // need_validate is a bool
+            //
+            if (c.size == sizeof(bool)) {
+                v.ivals.push_back(*(const bool*)p);
+            } else {
+                v.ivals.push_back(*(const int*)p);
+            }
+            raw_size += sizeof(int32_t);
+            break;
+        case COL_ID:
+            v.ivals.push_back(*(const DB_ID_TYPE*)p);
+            raw_size += sizeof(int64_t);
+            break;
+        case COL_DOUBLE:
+            v.dvals.push_back(*(const double*)p);
+            raw_size += sizeof(double);
+            break;
+        case COL_STRING:
+            v.svals.push_back(string(p, strnlen(p, c.size)));
+            raw_size += v.svals.back().size() + sizeof(uint32_t);
+            break;
+        }
+    }
+    nrows++;
+}
+
+// encode a string column, using a dictionary
+// if it has at most half as many distinct values as rows
+//
+static void encode_strings(string& buf, vector<string>& svals) {
+    map<string, uint32_t> dict;
+    vector<const string*> dict_vals;
+    unsigned char enc = COL_ENC_DICT;
+    for (unsigned int i=0; i<svals.size(); i++) {
+        if (dict.count(svals[i])) continue;
+        if (2*(dict.size()+1) > svals.size()) {
+            enc = COL_ENC_PLAIN;
+            break;
+        }
+        dict[svals[i]] = (uint32_t)dict_vals.size();
+        dict_vals.push_back(&svals[i]);
+    }
+
+    put(buf, &enc, 1);
+    if (enc == COL_ENC_DICT) {
+        put_u32(buf, (uint32_t)dict_vals.size());
+        for (unsigned int i=0; i<dict_vals.size(); i++) {
+            put_u32(buf, (uint32_t)dict_vals[i]->size());
+        }
+        for (unsigned int i=0; i<dict_vals.size(); i++) {
+            put(buf, dict_vals[i]->data(), dict_vals[i]->size());
+        }
+        for (unsigned int i=0; i<svals.size(); i++) {
+            put_u32(buf, dict[svals[i]]);
+        }
+    } else {
+        for (unsigned int i=0; i<svals.size(); i++) {
+            put_u32(buf, (uint32_t)svals[i].size());
+        }
+        for (unsigned int i=0; i<svals.size(); i++) {
+            put(buf, svals[i].data(), svals[i].size());
+        }
+    }
+}
+
+int COL_ARCHIVE_WRITER::write_block() {
+    if (!f) return ERR_NULL;
+    if (nrows == 0) {
+        return fflush(f)?ERR_FWRITE:0;
+    }
+
+    string raw, ranges;
+    raw.reserve(raw_size + ncols);
+    for (int i=0; i<ncols; i++) {
+        COL_ARCHIVE_VALUES& v = vals[i];
+        COL_ARCHIVE_RANGE range;
+        range.min = range.max = 0;
+        switch (cols[i].type) {
+        case COL_INT:
+            for (int j=0; j<nrows; j++) {
+                int32_t x = (int32_t)v.ivals[j];
+                put(raw, &x, sizeof(x));
+            }
+            break;
+        case COL_ID:
+            put(raw, &v.ivals[0], nrows*sizeof(int64_t));
+            break;
+        case COL_DOUBLE:
+            put(raw, &v.dvals[0], nrows*sizeof(double));
+            range.min = range.max = v.dvals[0];
+            for (int j=1; j<nrows; j++) {
+                if (v.dvals[j] < range.min) range.min = v.dvals[j];
+                if (v.dvals[j] > range.max) range.max = v.dvals[j];
+            }
+            break;
+        case COL_STRING:
+            encode_strings(raw, v.svals);
+            break;
+        }
+        if (cols[i].type == COL_INT || cols[i].type == COL_ID) {
+            int64_t imin = v.ivals[0], imax = v.ivals[0];
+            for (int j=1; j<nrows; j++) {
+                if (v.ivals[j] < imin) imin = v.ivals[j];
+                if (v.ivals[j] > imax) imax = v.ivals[j];
+            }
+            range.min = (double)imin;
+            range.max = (double)imax;
+        }
+        put(ranges, &range, sizeof(range));
+        v.clear();
+    }
+
+    uLongf comp_len = compressBound(raw.size());
+    vector<Bytef> comp(comp_len);
+    if (compress2(
+        &comp[0], &comp_len, (const Bytef*)raw.data(), raw.size(),
+        Z_DEFAULT_COMPRESSION
+    ) != Z_OK) {
+        return ERR_WRONG_SIZE;
+    }
+
+    string hdr;
+    put_u32(hdr, nrows);
+    put_u32(hdr, (uint32_t)raw.size());
+    put_u32(hdr, (uint32_t)comp_len);
+    hdr += ranges;
+
+    nrows = 0;
+    raw_size = 0;
+    if (fwrite(hdr.data(), 1, hdr.size(), f) != hdr.size()) return ERR_FWRITE;
+    if (fwrite(&comp[0], 1, comp_len, f) != comp_len) return ERR_FWRITE;
+    if (fflush(f)) return ERR_FWRITE;
+    return 0;
+}
+
+int COL_ARCHIVE_WRITER::close() {
+    if (!f) return 0;
+    int retval = write_block();
+    if (fclose(f) && !retval) retval = ERR_FWRITE;
+    f = NULL;
+    return retval;
+}
+
+////////////// reader ////////////////
+
+int COL_ARCHIVE_READER::open(const char* path) {
+    char magic[8];
+    uint32_t byte_order, ncols;
+
+    close();
+    f = fopen(path, "r");
+    if (!f) return ERR_FOPEN;
+    if (fread(magic, 1, sizeof(magic), f) != sizeof(magic)
+        || memcmp(magic, COL_ARCHIVE_MAGIC, sizeof(magic))
+        || fread(&byte_order, sizeof(byte_order), 1, f) != 1
+        || byte_order != COL_ARCHIVE_BYTE_ORDER
+        || fread(&ncols, sizeof(ncols), 1, f) != 1
+    ) {
+        close();
+        return ERR_BAD_FORMAT;
+    }
+    cols.resize(ncols);
+    for (unsigned int i=0; i<ncols; i++) {
+        unsigned char type, len;
+        char name[256];
+        if (fread(&type, 1, 1, f) != 1
+            || fread(&len, 1, 1, f) != 1
+            || fread(name, 1, len, f) != len
+            || type > COL_STRING
+        ) {
+            close();
+            return ERR_BAD_FORMAT;
+        }
+        cols[i].name = string(name, len);
+        cols[i].type = type;
+    }
+    return 0;
+}
+
+int COL_ARCHIVE_READER::col_index(const char* name) {
+    for (unsigned int i=0; i<cols.size(); i++) {
+        if (cols[i].name == name) return i;
+    }
+    return -1;
+}
+
+int COL_ARCHIVE_READER::read_block_header(COL_ARCHIVE_BLOCK_HEADER& bh) {
+    if (fread(&bh.nrows, sizeof(bh.nrows), 1, f) != 1) {
+        return feof(f)?ERR_NOT_FOUND:ERR_FREAD;
+    }
+    bh.ranges.resize(cols.size());
+    if (fread(&bh.raw_len, sizeof(bh.raw_len), 1, f) != 1
+        || fread(&bh.comp_len, sizeof(bh.comp_len), 1, f) != 1
+        || fread(&bh.ranges[0], sizeof(COL_ARCHIVE_RANGE), cols.size(), f)
+            != cols.size()
+    ) {
+        // a partial block; e.g. the writer crashed
+        //
+        return ERR_BAD_FORMAT;
+    }
+    return 0;
+}
+
+int COL_ARCHIVE_READER::skip_block(COL_ARCHIVE_BLOCK_HEADER& bh) {
+    if (fseek(f, bh.comp_len, SEEK_CUR)) return ERR_FREAD;
+    return 0;
+}
+
+int COL_ARCHIVE_READER::read_block(
+    COL_ARCHIVE_BLOCK_HEADER& bh, vector<COL_ARCHIVE_VALUES>& vals
+) {
+    vector<Bytef> comp(bh.comp_len);
+    if (fread(&comp[0], 1, bh.comp_len, f) != bh.comp_len) {
+        return ERR_BAD_FORMAT;
+    }
+    uLongf raw_len = bh.raw_len;
+    vector<char> raw(raw_len);
+    if (uncompress((Bytef*)&raw[0], &raw_len, &comp[0], bh.comp_len) != Z_OK
+        || raw_len != bh.raw_len
+    ) {
+        return ERR_BAD_FORMAT;
+    }
+
+    BUF_READER br(&raw[0], raw_len);
+    unsigned int n = bh.nrows;
+    vals.resize(cols.size());
+    for (unsigned int i=0; i<cols.size(); i++) {
+        COL_ARCHIVE_VALUES& v = vals[i];
+        v.clear();
+        switch (cols[i].type) {
+        case COL_INT:
+            for (unsigned int j=0; j<n; j++) {
+                int32_t x;
+                if (!br.get(&x, sizeof(x))) return ERR_BAD_FORMAT;
+                v.ivals.push_back(x);
+            }
+            break;
+        case COL_ID:
+            v.ivals.resize(n);
+            if (!br.get(&v.ivals[0], n*sizeof(int64_t))) return ERR_BAD_FORMAT;
+            break;
+        case COL_DOUBLE:
+            v.dvals.resize(n);
+            if (!br.get(&v.dvals[0], n*sizeof(double))) return ERR_BAD_FORMAT;
+            break;
+        case COL_STRING: {
+            unsigned char enc;
+            uint32_t ndict = n;
+            if (!br.get(&enc, 1)) return ERR_BAD_FORMAT;
+            if (enc == COL_ENC_DICT) {
+                if (!br.get_u32(ndict)) return ERR_BAD_FORMAT;
+            } else if (enc != COL_ENC_PLAIN) {
+                return ERR_BAD_FORMAT;
+            }
+            vector<uint32_t> lens(ndict);
+            vector<string> strs(ndict);
+            for (unsigned int j=0; j<ndict; j++) {
+                if (!br.get_u32(lens[j])) return ERR_BAD_FORMAT;
+            }
+            for (unsigned int j=0; j<ndict; j++) {
+                if (!br.get_string(strs[j], lens[j])) return ERR_BAD_FORMAT;
+            }
+            if (enc == COL_ENC_PLAIN) {
+                v.svals.swap(strs);
+                break;
+            }
+            for (unsigned int j=0; j<n; j++) {
+                uint32_t k;
+                if (!br.get_u32(k) || k >= ndict) return ERR_BAD_FORMAT;
+                v.svals.push_back(strs[k]);
+            }
+            break;
+        }
+        }
+    }
+    return 0;
+}
+
+void COL_ARCHIVE_READER::close() {
+    if (f) {
+        fclose(f);
+        f = NULL;
+    }
+}
@@ -0,0 +1,142 @@
+// This file is part of BOINC.
+// https://boinc.berkeley.edu
+// Copyright (C) 2026 University of California
+//
+// BOINC is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+// BOINC is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with BOINC.  If not, see <http://www.gnu.org/licenses/>.
+
+// Columnar archive files, written by db_purge --columnar
+// and read by archive_query.
+//
+// A file consists of a header describing the columns,
+// followed by a sequence of blocks.
+// Each block holds a group of rows, stored column by column
+// and compressed as a unit with zlib:
+//  - int columns: 4-byte ints
+//  - ID columns: 8-byte ints
+//  - double columns: 8-byte doubles
+//  - string columns: either a list of (length, bytes),
+//    or (if there are few distinct values) a dictionary of values
+//    and a 4-byte index per row
+// The (uncompressed) block header has the min and max of each
+// numeric column, so readers can skip blocks that can't match a query
+// (in particular, blocks outside a given ID range)
+// without decompressing them.
+//
+// Numbers are in the byte order of the writer;
+// the header has a marker so that readers can detect a mismatch.
+
+#ifndef BOINC_COL_ARCHIVE_H
+#define BOINC_COL_ARCHIVE_H
+
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define COL_ARCHIVE_MAGIC       "BOINCCA1"
+#define COL_ARCHIVE_BYTE_ORDER  0x01020304
+
+// column types
+//
+#define COL_INT         0
+#define COL_ID          1
+#define COL_DOUBLE      2
+#define COL_STRING      3
+
+// string column encodings
+//
+#define COL_ENC_PLAIN   0
+#define COL_ENC_DICT    1
+
+// a column, and where to get its value from a WORKUNIT or RESULT
+//
+struct COL_ARCHIVE_COLUMN {
+    const char* name;
+    int type;
+    size_t offset;
+    size_t size;
+};
+
+extern COL_ARCHIVE_COLUMN wu_archive_columns[];
+extern int n_wu_archive_columns;
+extern COL_ARCHIVE_COLUMN result_archive_columns[];
+extern int n_result_archive_columns;
+
+// the values of a column in a block
+//
+struct COL_ARCHIVE_VALUES {
+    std::vector<int64_t> ivals;     // COL_INT and COL_ID
+    std::vector<double> dvals;
+    std::vector<std::string> svals;
+
+    void clear() {
+        ivals.clear();
+        dvals.clear();
+        svals.clear();
+    }
+};
+
+// zone map for a numeric column: min and max value in a block
+//
+struct COL_ARCHIVE_RANGE {
+    double min, max;
+};
+
+struct COL_ARCHIVE_WRITER {
+    FILE* f;
+    COL_ARCHIVE_COLUMN* cols;
+    int ncols;
+    std::vector<COL_ARCHIVE_VALUES> vals;
+    int nrows;
+    size_t raw_size;
+        // approximate uncompressed size of the pending rows
+
+    COL_ARCHIVE_WRITER(): f(NULL), cols(NULL), ncols(0), nrows(0), raw_size(0) {}
+    int open(const char* path, COL_ARCHIVE_COLUMN* cols, int ncols);
+    void add_row(void* rec);
+        // rec is a WORKUNIT* or RESULT*, depending on the columns
+    int write_block();
+        // write pending rows (if any) as a block, and fflush()
+    int close();
+};
+
+struct COL_ARCHIVE_BLOCK_HEADER {
+    uint32_t nrows;
+    uint32_t raw_len;
+    uint32_t comp_len;
+    std::vector<COL_ARCHIVE_RANGE> ranges;
+};
+
+struct COL_ARCHIVE_COLUMN_INFO {
+    std::string name;
+    int type;
+};
+
+struct COL_ARCHIVE_READER {
+    FILE* f;
+    std::vector<COL_ARCHIVE_COLUMN_INFO> cols;
+
+    COL_ARCHIVE_READER(): f(NULL) {}
+    ~COL_ARCHIVE_READER() {close();}
+    int open(const char* path);
+    int col_index(const char* name);
+        // -1 if not found
+    int read_block_header(COL_ARCHIVE_BLOCK_HEADER&);
+        // ERR_NOT_FOUND at end of file
+    int skip_block(COL_ARCHIVE_BLOCK_HEADER&);
+    int read_block(COL_ARCHIVE_BLOCK_HEADER&, std::vector<COL_ARCHIVE_VALUES>&);
+    void close();
+};
+
+#endif
@@ -37,6 +37,8 @@
 #include <sys/wait.h>
 #include <string>
 #include <vector>
+#include <set>
+#include <algorithm>
 
 #include "boinc_db.h"
 #include "filesys.h"
@@ -54,8 +56,11 @@
 
 using std::string;
 using std::vector;
+using std::set;
 
 #define LOCKFILE "db_dump.out"
+#define DUMP_TIME_FILE "db_dump_time"
+    // in project dir; start time of last successful dump, for --incremental
 
 #define COMPRESSION_NONE    0
 #define COMPRESSION_GZIP    1
@@ -83,6 +88,10 @@ const char* tag_name[NUM_TABLES] = {"users", "teams", "hosts", "users_deleted",
 int nusers, nhosts, nteams, nusers_deleted, nhosts_deleted;
 double total_credit;
 bool have_badges = false;
+int dump_since = 0;
+    // if nonzero, dump only rows created or credited since this time
+set<DB_ID_TYPE> show_hosts_userids;
+    // users who let others see their hosts; for host detail
 
 struct OUTPUT {
     int recs_per_file;
@@ -323,6 +332,29 @@ public:
     }
 };
 
+// accumulates output in memory
+//
+class STRING_STREAM : public OUTPUT_STREAM
+{
+public:
+    string buf;
+
+    bool is_open() const {
+        return true;
+    }
+
+    bool open(const char*) {
+        buf.clear();
+        return true;
+    }
+
+    void close() {}
+
+    void write(const void* p, int size) {
+        buf.append((const char*)p, size);
+    }
+};
+
 // class that automatically compresses on close
 //
 class ZFILE {
@@ -330,6 +362,8 @@ protected:
     string tag;     // enclosing XML tag
     OUTPUT_STREAM* stream;
 public:
+    ZFILE(string tag_, OUTPUT_STREAM* s): tag(tag_), stream(s) {}
+
     ZFILE(string tag_, int comp): tag(tag_) {
         switch(comp) {
         case COMPRESSION_ZIP:
@@ -403,6 +437,25 @@ public:
         stream->write(ptr, size);
         free(ptr);
     }
+
+    // write text that's already formatted
+    //
+    void write_raw(const char* p, int size) {
+        if(!is_open())
+            return;
+        stream->write(p, size);
+    }
+};
+
+// a single record, formatted in memory
+//
+class RECORD_BUF : public ZFILE {
+public:
+    RECORD_BUF(): ZFILE("", new STRING_STREAM) {}
+
+    string& str() {
+        return ((STRING_STREAM*)stream)->buf;
+    }
 };
 
 // class that automatically opens a new file every N IDs
@@ -443,7 +496,6 @@ void write_host_deleted(HOST_DELETED& host_deleted, ZFILE* f) {
 }
 
 void write_host(HOST& host, ZFILE* f, bool detail) {
-    int retval;
     char p_vendor[2048], p_model[2048], os_name[2048], os_version[2048];
 
     xml_escape(host.p_vendor, p_vendor, sizeof(p_vendor));
@@ -455,22 +507,11 @@ void write_host(HOST& host, ZFILE* f, bool detail) {
         "    <id>%lu</id>\n",
         host.id
     );
-    if (detail) {
-        DB_USER user;
-        retval = user.lookup_id(host.userid);
-        if (retval) {
-            log_messages.printf(MSG_CRITICAL,
-                "user lookup of user %lu for host %lu: %s\n",
-                host.userid, host.id, boincerror(retval)
-            );
-        } else {
-            if (user.show_hosts) {
-                f->write(
-                    "    <userid>%lu</userid>\n",
-                    host.userid
-                );
-            }
-        }
+    if (detail && show_hosts_userids.count(host.userid)) {
+        f->write(
+            "    <userid>%lu</userid>\n",
+            host.userid
+        );
     }
     f->write(
         "    <total_credit>%f</total_credit>\n"
@@ -834,124 +875,176 @@ int tables_file(char* dir) {
     if (nusers_deleted) zf.write("    <nusers_deleted_total>%d</nusers_deleted_total>\n", nusers_deleted);
     if (nhosts_deleted) zf.write("    <nhosts_deleted_total>%d</nhosts_deleted_total>\n", nhosts_deleted);
     if (total_credit) zf.write("    <total_credit>%lf</total_credit>\n", total_credit);
+    if (dump_since) zf.write("    <incremental_since>%d</incremental_since>\n", dump_since);
     print_apps(&zf);
     print_badges(&zf);
     zf.close();
     return 0;
 }
 
-int ENUMERATION::make_it_happen(char* output_dir) {
-    int n, retval;
+// Each table is read from the DB once.
+// The XML for each row is appended to a spool file
+// (one for outputs with <detail/>, one for those without)
+// and its sort keys and location are kept in memory.
+// Each enumeration then sorts the row list as needed,
+// and copies the XML from the spool files to its outputs.
+//
+struct DUMP_ROW {
+    DB_ID_TYPE id;
+    double total_credit;
+    double expavg_credit;
+    long offset[2];
+    int len[2];
+        // [1] is the detail version
+};
+
+struct TABLE_DUMP {
+    bool need[2];
+        // need[1]: some output has <detail/>; need[0]: some output doesn't
+    vector<DUMP_ROW> rows;
+    FILE* spool[2];
+    char spool_path[2][MAXPATHLEN];
+    RECORD_BUF rb[2];
+
+    TABLE_DUMP() {
+        need[0] = need[1] = false;
+        spool[0] = spool[1] = NULL;
+    }
+    void add_row(DUMP_ROW&);
+};
+
+TABLE_DUMP table_dumps[NUM_TABLES];
+
+void TABLE_DUMP::add_row(DUMP_ROW& row) {
+    for (int d=0; d<2; d++) {
+        row.offset[d] = 0;
+        row.len[d] = 0;
+        if (!need[d]) continue;
+        string& s = rb[d].str();
+        row.offset[d] = ftell(spool[d]);
+        row.len[d] = (int)s.size();
+        if (fwrite(s.data(), 1, s.size(), spool[d]) != s.size()) {
+            log_messages.printf(MSG_CRITICAL,
+                "Can't write %s\n", spool_path[d]
+            );
+            exit(ERR_FWRITE);
+        }
+        s.clear();
+    }
+    rows.push_back(row);
+}
+
+// order of rows for an enumeration; ties keep the DB order
+//
+struct ROW_ORDER {
+    vector<DUMP_ROW>& rows;
+    int sort;
+
+    ROW_ORDER(vector<DUMP_ROW>& r, int s): rows(r), sort(s) {}
+    bool operator()(int a, int b) const {
+        switch (sort) {
+        case SORT_ID:
+            return rows[a].id < rows[b].id;
+        case SORT_TOTAL_CREDIT:
+            return rows[a].total_credit > rows[b].total_credit;
+        case SORT_EXPAVG_CREDIT:
+            return rows[a].expavg_credit > rows[b].expavg_credit;
+        }
+        return false;
+    }
+};
+
+// if the consent type for stats export is enabled,
+// change the clause to select only rows of users who have consented
+//
+void add_consent_join(char* clause, int clause_size, const char* userid_col) {
+    DB_CONSENT_TYPE consent_type;
+    char lookupclause[256];
+    char joinclause[1024];
+
+    sprintf(lookupclause, "where shortname = '%s'", CONSENT_TO_STATISTICS_EXPORT);
+    int retval = consent_type.lookup(lookupclause);
+    if (retval || !consent_type.enabled) return;
+
+    // This INNER JOIN clause joins the table with the latest_consent
+    // View table (see schema.sql for this view's definition),
+    // which represents the latest consent status for all users
+    // and consent_types.
+    //
+    snprintf(joinclause, sizeof(joinclause), "INNER JOIN (\
+        SELECT userid\
+          FROM latest_consent\
+         WHERE consent_type_id=%ld\
+           AND consent_flag=1) AS lc\
+        ON %s = lc.userid %s", consent_type.id, userid_col, clause
+    );
+    strlcpy(clause, joinclause, clause_size);
+}
+
+// read a table from the DB, and write its rows to spool files
+//
+void read_table(int table, char* output_dir) {
+    TABLE_DUMP& td = table_dumps[table];
     DB_USER user;
     DB_USER_DELETED user_deleted;
     DB_TEAM team;
     DB_HOST host;
     DB_HOST_DELETED host_deleted;
-    DB_RESULT result;
-    DB_CONSENT_TYPE consent_type;
-    char clause[512];
-    char lookupclause[256];
-    char userclause[256];
-    char hostclause[256];
-    char teamclause[256];
-    char joinclause[512];
-    char orderclause[256];
-    char path[MAXPATHLEN];
+    DUMP_ROW row;
+    char clause[1024];
+    char since_clause[256];
     long ncount;
     double sumtotalcredit;
+    int d, retval;
 
-    sprintf(path, "%s/%s", output_dir, filename);
-
-    for (OUTPUT& out: outputs) {
-        if (out.recs_per_file) {
-            out.nzfile = new NUMBERED_ZFILE(
-                tag_name[table], out.compression, path, out.recs_per_file
+    for (d=0; d<2; d++) {
+        if (!td.need[d]) continue;
+        snprintf(td.spool_path[d], sizeof(td.spool_path[d]),
+            "%s/%s_%d.spool", output_dir, table_name[table], d
+        );
+        td.spool[d] = fopen(td.spool_path[d], "w+");
+        if (!td.spool[d]) {
+            log_messages.printf(MSG_CRITICAL,
+                "Couldn't open %s for output\n", td.spool_path[d]
             );
-        } else {
-            out.zfile = new ZFILE(tag_name[table], out.compression);
-            out.zfile->open(path);
+            exit(ERR_FOPEN);
         }
     }
 
-    // Generate the SQL necessary for retrieving data
-    // host, user, and team where clauses
-    safe_strcpy(userclause, "WHERE total_credit > 0 AND authenticator NOT LIKE 'deleted%'");
-    safe_strcpy(hostclause, "WHERE total_credit > 0 AND domain_name != 'deleted' AND host.userid != 0");
-    safe_strcpy(teamclause, "WHERE total_credit > 0");
-
-    // set order clause based on sort type
-    switch(sort) {
-    case SORT_NONE:
-        safe_strcpy(orderclause, "");
-        break;
-    case SORT_ID:
-        safe_strcpy(orderclause, "ORDER BY id");
-        break;
-    case SORT_TOTAL_CREDIT:
-        safe_strcpy(orderclause, "ORDER BY total_credit DESC");
-        break;
-    case SORT_EXPAVG_CREDIT:
-        safe_strcpy(orderclause, "ORDER BY expavg_credit DESC");
-        break;
+    // in incremental mode, rows created or credited since the last dump
+    //
+    strcpy(since_clause, "");
+    if (dump_since) {
+        sprintf(since_clause,
+            " AND (expavg_time > %d OR create_time > %d)",
+            dump_since, dump_since
+        );
     }
 
     switch(table) {
     case TABLE_USER:
-	// Count number of users, this needs to be independent of
-	// CONSENT_TO_STATISTICS_EXPORT.
-
-        // SQL clause to ignore deleted users.
-        safe_strcpy(clause, userclause);
-	safe_strcat(clause, " ");
-	safe_strcat(clause, orderclause);
-
-	retval = user.count(ncount, clause);
-	if (!retval) nusers = ncount;
-
-	retval = user.sum(sumtotalcredit, "total_credit", clause);
-	if (!retval) total_credit = sumtotalcredit;
-
-	// lookup consent_type
-	sprintf(lookupclause, "where shortname = '%s'", CONSENT_TO_STATISTICS_EXPORT);
-	retval = consent_type.lookup(lookupclause);
-	// If retval is 0: lookup is successful, and consent_type
-	// enabled flag is true, then edit the SQL clause to use the
-	// JOIN statements to extract only the users who have
-	// consented to statistics exports.
-	if ( (!retval) && (consent_type.enabled) ) {
-	    // This INNER JOIN clause does the following. It joins the
-	    // user table with the latest_consent View table, see
-	    // schema.sql for this view's definition. The
-	    // latest_consent represents the latest consent status for
-	    // all users and consent_types. Effectively returning users
-	    // who have consented to statistics exports.
-	    sprintf(joinclause, "INNER JOIN (\
-            SELECT userid\
-              FROM latest_consent\
-             WHERE consent_type_id=%ld\
-               AND consent_flag=1) AS lc\
-            ON user.id = lc.userid", consent_type.id);
-	    safe_strcat(joinclause, " ");
-	    safe_strcat(joinclause, clause);
-	    safe_strcpy(clause, joinclause);
-	}
-
-        n = 0;
+        // count users and credit, independent of
+        // CONSENT_TO_STATISTICS_EXPORT and incremental mode
+        //
+        safe_strcpy(clause, "WHERE total_credit > 0 AND authenticator NOT LIKE 'deleted%'");
+        retval = user.count(ncount, clause);
+        if (!retval) nusers = ncount;
+        retval = user.sum(sumtotalcredit, "total_credit", clause);
+        if (!retval) total_credit = sumtotalcredit;
+
+        safe_strcat(clause, since_clause);
+        add_consent_join(clause, sizeof(clause), "user.id");
         while (1) {
             retval = user.enumerate(clause, true);
             if (retval) break;
-
             if (!strncmp("deleted", user.authenticator, 7)) continue;
-            for (OUTPUT& out: outputs) {
-                if (sort == SORT_ID && out.recs_per_file) {
-                    out.nzfile->set_id(n++);
-                }
-                if (out.zfile) {
-                    write_user(user, out.zfile, out.detail);
-                } else {
-                    write_user(user, out.nzfile, out.detail);
-                }
+            for (d=0; d<2; d++) {
+                if (td.need[d]) write_user(user, &td.rb[d], d);
             }
+            row.id = user.id;
+            row.total_credit = user.total_credit;
+            row.expavg_credit = user.expavg_credit;
+            td.add_row(row);
         }
         if (retval != ERR_DB_NOT_FOUND) {
             log_messages.printf(MSG_CRITICAL,
@@ -961,21 +1054,21 @@ int ENUMERATION::make_it_happen(char* output_dir) {
         }
         break;
     case TABLE_USER_DELETED:
-        n = 0;
+        retval = user_deleted.count(ncount, "");
+        if (!retval) nusers_deleted = ncount;
+        clause[0] = 0;
+        if (dump_since) {
+            sprintf(clause, "where create_time > %d", dump_since);
+        }
         while (1) {
-            retval = user_deleted.enumerate("order by userid");
+            retval = user_deleted.enumerate(clause);
             if (retval) break;
-            nusers_deleted++;
-            for (OUTPUT& out: outputs) {
-                if (sort == SORT_ID && out.recs_per_file) {
-                    out.nzfile->set_id(n++);
-                }
-                if (out.zfile) {
-                    write_user_deleted(user_deleted, out.zfile);
-                } else {
-                    write_user_deleted(user_deleted, out.nzfile);
-                }
+            for (d=0; d<2; d++) {
+                if (td.need[d]) write_user_deleted(user_deleted, &td.rb[d]);
             }
+            row.id = user_deleted.userid;
+            row.total_credit = row.expavg_credit = 0;
+            td.add_row(row);
         }
         if (retval != ERR_DB_NOT_FOUND) {
             log_messages.printf(MSG_CRITICAL,
@@ -985,59 +1078,32 @@ int ENUMERATION::make_it_happen(char* output_dir) {
         }
         break;
     case TABLE_HOST:
-	// Count number of hosts, this needs to be independent of
-	// CONSENT_TO_STATISTICS_EXPORT.
-
-        // SQL clause to ignore deleted hosts.
-        safe_strcpy(clause, hostclause);
-	safe_strcat(clause, " ");
-	safe_strcat(clause, orderclause);
-
-	retval = host.count(ncount, clause);
-	if (!retval) nhosts = ncount;
-
-	// lookup consent_type
-	sprintf(lookupclause, "where shortname = '%s'", CONSENT_TO_STATISTICS_EXPORT);
-	retval = consent_type.lookup(lookupclause);
-	// If retval is 0: lookup is successful, and consent_type
-	// enabled flag is true, then edit the SQL clause to use the
-	// JOIN statements to extract only the users who have
-	// consented to statistics exports.
-	if ( (!retval) && (consent_type.enabled) ) {
-	    // This INNER JOIN clause does the following. It joins the
-	    // host table with the latest_consent View table, see
-	    // schema.sql for this view's definition. The
-	    // latest_consent represents the latest consent status for
-	    // all users and consent_types. Effectively returning
-	    // hosts of users who have consented to statistics
-	    // exports.
-	    sprintf(joinclause, "INNER JOIN (\
-            SELECT userid\
-              FROM latest_consent\
-             WHERE consent_type_id=%ld\
-               AND consent_flag=1) AS lc\
-            ON host.userid = lc.userid", consent_type.id);
-	    safe_strcat(joinclause, " ");
-	    safe_strcat(joinclause, clause);
-	    safe_strcpy(clause, joinclause);
-	}
-
-        n = 0;
+        safe_strcpy(clause, "WHERE total_credit > 0 AND domain_name != 'deleted' AND host.userid != 0");
+        retval = host.count(ncount, clause);
+        if (!retval) nhosts = ncount;
+
+        // rather than looking up each host's user
+        //
+        if (td.need[1]) {
+            while (!user.enumerate("where show_hosts<>0", true)) {
+                show_hosts_userids.insert(user.id);
+            }
+        }
+
+        safe_strcat(clause, since_clause);
+        add_consent_join(clause, sizeof(clause), "host.userid");
         while(1) {
-            retval = host.enumerate(clause);
+            retval = host.enumerate(clause, true);
             if (retval) break;
             if (!host.userid) continue;
             if (!strncmp("deleted", host.domain_name, 8)) continue;
-            for (OUTPUT& out: outputs) {
-                if (sort == SORT_ID && out.recs_per_file) {
-                    out.nzfile->set_id(n++);
-                }
-                if (out.zfile) {
-                    write_host(host, out.zfile, out.detail);
-                } else {
-                    write_host(host, out.nzfile, out.detail);
-                }
+            for (d=0; d<2; d++) {
+                if (td.need[d]) write_host(host, &td.rb[d], d);
             }
+            row.id = host.id;
+            row.total_credit = host.total_credit;
+            row.expavg_credit = host.expavg_credit;
+            td.add_row(row);
         }
         if (retval != ERR_DB_NOT_FOUND) {
             log_messages.printf(MSG_CRITICAL,
@@ -1047,21 +1113,21 @@ int ENUMERATION::make_it_happen(char* output_dir) {
         }
         break;
     case TABLE_HOST_DELETED:
-        n = 0;
+        retval = host_deleted.count(ncount, "");
+        if (!retval) nhosts_deleted = ncount;
+        clause[0] = 0;
+        if (dump_since) {
+            sprintf(clause, "where create_time > %d", dump_since);
+        }
         while(1) {
-            retval = host_deleted.enumerate("order by hostid");
+            retval = host_deleted.enumerate(clause);
             if (retval) break;
-            nhosts_deleted++;
-            for (OUTPUT& out: outputs) {
-                if (sort == SORT_ID && out.recs_per_file) {
-                    out.nzfile->set_id(n++);
-                }
-                if (out.zfile) {
-                    write_host_deleted(host_deleted, out.zfile);
-                } else {
-                    write_host_deleted(host_deleted, out.nzfile);
-                }
+            for (d=0; d<2; d++) {
+                if (td.need[d]) write_host_deleted(host_deleted, &td.rb[d]);
             }
+            row.id = host_deleted.hostid;
+            row.total_credit = row.expavg_credit = 0;
+            td.add_row(row);
         }
         if (retval != ERR_DB_NOT_FOUND) {
             log_messages.printf(MSG_CRITICAL,
@@ -1071,26 +1137,23 @@ int ENUMERATION::make_it_happen(char* output_dir) {
         }
         break;
     case TABLE_TEAM:
-        // SQL clause for teams.
-        safe_strcpy(clause, teamclause);
-	safe_strcat(clause, " ");
-	safe_strcat(clause, orderclause);
+        safe_strcpy(clause, "WHERE total_credit > 0");
+        retval = team.count(ncount, clause);
+        if (!retval) nteams = ncount;
 
-        n = 0;
+        // team detail does a query per team, so don't stream
+        //
+        safe_strcat(clause, since_clause);
         while(1) {
             retval = team.enumerate(clause);
             if (retval) break;
-            nteams++;
-            for (OUTPUT& out: outputs) {
-                if (sort == SORT_ID && out.recs_per_file) {
-                    out.nzfile->set_id(n++);
-                }
-                if (out.zfile) {
-                    write_team(team, out.zfile, out.detail);
-                } else {
-                    write_team(team, out.nzfile, out.detail);
-                }
+            for (d=0; d<2; d++) {
+                if (td.need[d]) write_team(team, &td.rb[d], d);
             }
+            row.id = team.id;
+            row.total_credit = team.total_credit;
+            row.expavg_credit = team.expavg_credit;
+            td.add_row(row);
         }
         if (retval != ERR_DB_NOT_FOUND) {
             log_messages.printf(MSG_CRITICAL,
@@ -1100,6 +1163,87 @@ int ENUMERATION::make_it_happen(char* output_dir) {
         }
         break;
     }
+
+    for (d=0; d<2; d++) {
+        if (td.need[d] && fflush(td.spool[d])) {
+            log_messages.printf(MSG_CRITICAL,
+                "Can't write %s\n", td.spool_path[d]
+            );
+            exit(ERR_FWRITE);
+        }
+    }
+    log_messages.printf(MSG_NORMAL,
+        "read %d rows from %s\n", (int)td.rows.size(), table_name[table]
+    );
+}
+
+void remove_spool_files() {
+    for (int i=0; i<NUM_TABLES; i++) {
+        TABLE_DUMP& td = table_dumps[i];
+        for (int d=0; d<2; d++) {
+            if (!td.need[d]) continue;
+            fclose(td.spool[d]);
+            unlink(td.spool_path[d]);
+        }
+    }
+}
+
+// write the outputs of an enumeration from the table's spool files.
+// This doesn't use the DB, so it can run in a child process.
+//
+int ENUMERATION::make_it_happen(char* output_dir) {
+    TABLE_DUMP& td = table_dumps[table];
+    char path[MAXPATHLEN];
+    vector<int> order;
+    vector<char> buf;
+    unsigned int i;
+
+    sprintf(path, "%s/%s", output_dir, filename);
+
+    for (OUTPUT& out: outputs) {
+        if (out.recs_per_file) {
+            out.nzfile = new NUMBERED_ZFILE(
+                tag_name[table], out.compression, path, out.recs_per_file
+            );
+        } else {
+            out.zfile = new ZFILE(tag_name[table], out.compression);
+            out.zfile->open(path);
+        }
+    }
+
+    order.resize(td.rows.size());
+    for (i=0; i<order.size(); i++) {
+        order[i] = i;
+    }
+    if (sort != SORT_NONE) {
+        std::stable_sort(order.begin(), order.end(), ROW_ORDER(td.rows, sort));
+    }
+
+    for (i=0; i<order.size(); i++) {
+        DUMP_ROW& row = td.rows[order[i]];
+        for (OUTPUT& out: outputs) {
+            int d = out.detail?1:0;
+            buf.resize(row.len[d]);
+            // use pread(), since child processes share the file offset
+            //
+            if (pread(fileno(td.spool[d]), &buf[0], row.len[d], row.offset[d])
+                != row.len[d]
+            ) {
+                log_messages.printf(MSG_CRITICAL,
+                    "Can't read %s\n", td.spool_path[d]
+                );
+                exit(ERR_READ);
+            }
+            if (sort == SORT_ID && out.recs_per_file) {
+                out.nzfile->set_id(i);
+            }
+            if (out.zfile) {
+                out.zfile->write_raw(&buf[0], row.len[d]);
+            } else {
+                out.nzfile->write_raw(&buf[0], row.len[d]);
+            }
+        }
+    }
     for (OUTPUT& out: outputs) {
         if (out.zfile) {
           out.zfile->close();
@@ -1124,6 +1268,8 @@ void usage(char* name) {
         "    [-d N | --debug_level]        Set verbosity level (1 to 4)\n"
         "    [--db_host H]                 Use the DB server on host H\n"
         "    [--retry_period H]            When can't connect to DB, retry after N sec instead of terminating\n"
+        "    [--nprocs N]                  Write and compress up to N enumerations at once\n"
+        "    [--incremental]               Dump only rows created or credited since the last dump\n"
         "    [-h | --help]                 Show this\n"
         "    [-v | --version]              Show version information\n",
         name
@@ -1137,6 +1283,9 @@ int main(int argc, char** argv) {
     char spec_filename[256], buf[256];
     FILE_LOCK file_lock;
     int retry_period = 0;
+    int nprocs = 1;
+    bool incremental = false;
+    int start_time = (int)time(0);
 
     check_stop_daemons();
     setbuf(stderr, 0);
@@ -1161,6 +1310,16 @@ int main(int argc, char** argv) {
             retry_period = atoi(argv[i]);
             if (retry_period < 0) retry_period = 0;
             if (retry_period > 1000000) retry_period = 1000000;
+        } else if (is_arg(argv[i], "nprocs")) {
+            if (!argv[++i]) {
+                log_messages.printf(MSG_CRITICAL, "%s requires an argument\n\n", argv[--i]);
+                usage(argv[0]);
+                exit(1);
+            }
+            nprocs = atoi(argv[i]);
+            if (nprocs < 1) nprocs = 1;
+        } else if (is_arg(argv[i], "incremental")) {
+            incremental = true;
         } else if (is_arg(argv[i], "d") || is_arg(argv[i], "debug_level")) {
             if (!argv[++i]) {
                 log_messages.printf(MSG_CRITICAL, "%s requires an argument\n\n", argv[--i]);
@@ -1257,8 +1416,74 @@ int main(int argc, char** argv) {
 
     boinc_mkdir(spec.output_dir);
 
+    if (incremental) {
+        f = fopen(config.project_path(DUMP_TIME_FILE), "r");
+        if (f) {
+            if (fscanf(f, "%d", &dump_since) != 1) dump_since = 0;
+            fclose(f);
+        }
+        if (dump_since) {
+            log_messages.printf(MSG_NORMAL,
+                "dumping rows changed since %d\n", dump_since
+            );
+        } else {
+            log_messages.printf(MSG_NORMAL,
+                "no previous dump; dumping all rows\n"
+            );
+        }
+    }
+
+    // read each table once
+    //
     for (ENUMERATION& e: spec.enumerations) {
-        e.make_it_happen(spec.output_dir);
+        for (OUTPUT& out: e.outputs) {
+            table_dumps[e.table].need[out.detail?1:0] = true;
+        }
+    }
+    for (i=0; i<NUM_TABLES; i++) {
+        if (table_dumps[i].need[0] || table_dumps[i].need[1]) {
+            read_table(i, spec.output_dir);
+        }
+    }
+
+    // write the enumerations, in parallel if requested.
+    // Most of the time goes to compression.
+    //
+    int nrunning = 0, nfailed = 0, status;
+    for (ENUMERATION& e: spec.enumerations) {
+        if (nprocs == 1) {
+            e.make_it_happen(spec.output_dir);
+            continue;
+        }
+        if (nrunning == nprocs) {
+            wait(&status);
+            if (!WIFEXITED(status) || WEXITSTATUS(status)) nfailed++;
+            nrunning--;
+        }
+        int pid = fork();
+        if (pid == 0) {
+            // don't touch the parent's DB connection on exit
+            //
+            _exit(e.make_it_happen(spec.output_dir));
+        }
+        if (pid < 0) {
+            log_messages.printf(MSG_CRITICAL, "fork() failed\n");
+            exit(1);
+        }
+        nrunning++;
+    }
+    while (nrunning) {
+        wait(&status);
+        if (!WIFEXITED(status) || WEXITSTATUS(status)) nfailed++;
+        nrunning--;
+    }
+    remove_spool_files();
+    if (nfailed) {
+        log_messages.printf(MSG_CRITICAL,
+            "%d enumerations failed\n", nfailed
+        );
+        boinc_db.close();
+        exit(1);
     }
 
     if (config.credit_by_app) {
@@ -1326,6 +1551,11 @@ int main(int argc, char** argv) {
         boinc_db.close();
         exit(1);
     }
+    f = fopen(config.project_path(DUMP_TIME_FILE), "w");
+    if (f) {
+        fprintf(f, "%d\n", start_time);
+        fclose(f);
+    }
     log_messages.printf(MSG_NORMAL, "db_dump finished\n");
     boinc_db.close();
 }
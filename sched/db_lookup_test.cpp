@@ -0,0 +1,116 @@
+// This file is part of BOINC.
+// https://boinc.berkeley.edu
+// Copyright (C) 2026 University of California
+//
+// BOINC is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+// BOINC is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with BOINC.  If not, see <http://www.gnu.org/licenses/>.
+
+// db_lookup_test
+//
+// Compare the speed of lookup_id() using regular queries
+// and using prepared statements, for the result and host tables,
+// and check that they return the same data.
+// Run in a project directory.  Doesn't modify anything.
+//
+// usage: db_lookup_test [--n N]
+//  --n N       number of lookups per table and method (default 10000)
+
+#include "config.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "util.h"
+
+#include "boinc_db.h"
+#include "sched_config.h"
+
+int nlookups = 10000;
+
+// look up N random IDs in the table, and return lookups/sec.
+//
+double do_lookups(DB_BASE& rec, DB_ID_TYPE max_id, bool prepared) {
+    boinc_db.use_prepared = prepared;
+    srand(1);
+    double start = dtime();
+    for (int i=0; i<nlookups; i++) {
+        DB_ID_TYPE id = 1 + (DB_ID_TYPE)(drand()*max_id);
+        rec.lookup_id(id);
+    }
+    return nlookups/(dtime()-start);
+}
+
+static char buf1[MAX_QUERY_LEN*2], buf2[MAX_QUERY_LEN*2];
+
+void test_table(DB_BASE& rec) {
+    DB_ID_TYPE max_id;
+
+    if (rec.max_id(max_id) || max_id == 0) {
+        printf("%s: no rows\n", rec.table_name);
+        return;
+    }
+
+    // check that both methods give the same record
+    //
+    boinc_db.use_prepared = false;
+    if (rec.lookup_id(max_id)) {
+        printf("%s: lookup of %lu failed\n", rec.table_name, max_id);
+        return;
+    }
+    rec.db_print(buf1);
+    boinc_db.use_prepared = true;
+    if (rec.lookup_id(max_id)) {
+        printf("%s: prepared lookup of %lu failed\n", rec.table_name, max_id);
+        return;
+    }
+    rec.db_print(buf2);
+    if (strcmp(buf1, buf2)) {
+        printf("%s: prepared lookup of %lu doesn't match:\n%s\n%s\n",
+            rec.table_name, max_id, buf1, buf2
+        );
+    }
+
+    double text_rate = do_lookups(rec, max_id, false);
+    double prep_rate = do_lookups(rec, max_id, true);
+    printf("%s: %d lookups: query %.0f/sec, prepared %.0f/sec\n",
+        rec.table_name, nlookups, text_rate, prep_rate
+    );
+}
+
+int main(int argc, char** argv) {
+    for (int i=1; i<argc; i++) {
+        if (!strcmp(argv[i], "--n") && i+1 < argc) {
+            nlookups = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: db_lookup_test [--n N]\n");
+            exit(1);
+        }
+    }
+    int retval = config.parse_file();
+    if (retval) {
+        fprintf(stderr, "can't parse config.xml\n");
+        exit(1);
+    }
+    retval = boinc_db.open(
+        config.db_name, config.db_host, config.db_user, config.db_passwd
+    );
+    if (retval) {
+        fprintf(stderr, "can't open DB\n");
+        exit(1);
+    }
+
+    DB_RESULT result;
+    test_table(result);
+    DB_HOST host;
+    test_table(host);
+}
@@ -34,6 +34,11 @@
 // where TIME is the time it was created.
 // In addition, generate index files associating each WU and result ID
 // with the timestamp of the file it's in.
+//
+// With --columnar, WUs and results are instead written to
+// wu_archive_TIME.col and result_archive_TIME.col
+// in a compact binary format (see col_archive.h)
+// that can be queried with archive_query.
 
 #include "config.h"
 #include <cstdio>
@@ -44,12 +49,16 @@
 #include <cstdlib>
 #include <ctime>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <sys/wait.h>
 #include <time.h>
 #include <errno.h>
 #include <string.h>
 #include "zlib.h"
 
 using std::string;
+using std::vector;
 
 #include "boinc_db.h"
 #include "filesys.h"
@@ -65,6 +74,8 @@ using std::string;
 #include "error_numbers.h"
 #include "str_util.h"
 
+#include "col_archive.h"
+
 void usage() {
     fprintf(stderr,
         "Purge workunit and result records that are no longer needed.\n\n"
@@ -76,6 +87,7 @@ void usage() {
         "   --zip                       Compress output files by piping through zip\n"
         "   --gzip                      Compress output files by piping through gzip\n"
         "   --zlib                      Compress output files using zlib\n"
+        "   --columnar                  Write WUs and results in compressed columnar format\n"
         "   --no_archive                Don't write output files, just purge\n"
         "   --daily_dir                 Write archives in a new directory each day\n"
         "   --max_wu_per_file N         Write at most N WUs per output file\n"
@@ -83,6 +95,7 @@ void usage() {
         "   --one_pass                  Make one DB scan, then exit\n"
         "   --dont_delete               Don't actually delete anything from the DB (for testing)\n"
         "   --mod M R                   Handle only WUs with ID mod M == R\n"
+        "   --nprocs N                  Purge using N processes (requires --no_archive)\n"
         "   -h or --help                Show this help text\n"
         "   -v or --version             Show version information\n"
     );
@@ -94,11 +107,16 @@ void usage() {
 #define RESULT_INDEX_FILENAME_PREFIX    "result_index"
 
 #define DB_QUERY_LIMIT                  1000
+#define PURGE_CHUNK_SIZE                100
+    // archive and delete this many WUs (and their results) at once
 
 #define COMPRESSION_NONE    0
 #define COMPRESSION_GZIP    1
 #define COMPRESSION_ZIP     2
 #define COMPRESSION_ZLIB    3
+#define COMPRESSION_COLUMNAR    4
+    // WU and result archives in columnar format (see col_archive.h);
+    // index files are not compressed
 
 #define WU_ARCHIVE_DATA \
         "<workunit_archive>\n" \
@@ -231,6 +249,11 @@ void* re_stream=NULL;
 void* wu_index_stream=NULL;
 void* re_index_stream=NULL;
 
+// used instead of wu_stream and re_stream if --columnar
+//
+COL_ARCHIVE_WRITER wu_col_archive;
+COL_ARCHIVE_WRITER re_col_archive;
+
 int time_int=0;
 double min_age_days = 0;
 bool no_archive = false;
@@ -243,7 +266,7 @@ int max_number_workunits_to_purge = 0;
     // this also limits the number of purged results.
 int purged_workunits = 0;
     // # of WUs purged so far
-const char *suffix[4] = {"", ".gz", ".zip", ".gz"};
+const char *suffix[5] = {"", ".gz", ".zip", ".gz", ""};
     // subscripts MUST be in agreement with defines above
 int compression_type = COMPRESSION_NONE;
 int max_wu_per_file = 0;
@@ -253,6 +276,8 @@ int wu_stored_in_file = 0;
     // keep track of how many WU archived in file so far
 int id_modulus=0, id_remainder=0;
     // allow more than one to run - doesn't work if archiving is enabled
+int nprocs = 1;
+    // run this many processes, each doing a different id_remainder
 char app_name[256];
 DB_APP app;
 
@@ -269,41 +294,57 @@ void fail(const char* msg) {
     exit(1);
 }
 
-// Open an archive.
-// If the user has asked for compression,
-// then we popen(2) a pipe to gzip or zip.
-// This does 'in place' compression.
+// get the path of an archive file
 //
-void open_archive(const char* filename_prefix, void*& f){
-    char path[MAXPATHLEN];
-    char command[MAXPATHLEN+512];
-    sprintf(command, "/bin/false");
-
+void archive_path(const char* prefix, const char* ext, char* path) {
     if (daily_dir) {
         time_t time_time = time_int;
         char dirname[32];
         strftime(dirname, sizeof(dirname), "%Y_%m_%d", gmtime(&time_time));
-        safe_strcpy(path, config.project_path("archives/%s",dirname));
-        if (mkdir(path,0775)) {
-            if(errno!=EEXIST) {
-                char errstr[256];
-                sprintf(errstr, "could not create directory '%s': %s\n",
-                path, strerror(errno));
-                fail(errstr);
-            }
-        }
-        safe_strcpy(path,
+        strlcpy(path,
             config.project_path(
-                "archives/%s/%s_%d.xml", dirname, filename_prefix, time_int
-            )
+                "archives/%s/%s_%d%s", dirname, prefix, time_int, ext
+            ),
+            MAXPATHLEN
         );
     } else {
-        safe_strcpy(path,
-            config.project_path("archives/%s_%d.xml", filename_prefix, time_int)
+        strlcpy(path,
+            config.project_path("archives/%s_%d%s", prefix, time_int, ext),
+            MAXPATHLEN
         );
     }
+}
+
+void make_daily_dir() {
+    char path[MAXPATHLEN];
+    time_t time_time = time_int;
+    char dirname[32];
+    strftime(dirname, sizeof(dirname), "%Y_%m_%d", gmtime(&time_time));
+    safe_strcpy(path, config.project_path("archives/%s",dirname));
+    if (mkdir(path,0775)) {
+        if(errno!=EEXIST) {
+            char errstr[256];
+            sprintf(errstr, "could not create directory '%s': %s\n",
+            path, strerror(errno));
+            fail(errstr);
+        }
+    }
+}
+
+// Open an archive.
+// If the user has asked for compression,
+// then we popen(2) a pipe to gzip or zip.
+// This does 'in place' compression.
+//
+void open_archive(const char* filename_prefix, void*& f){
+    char path[MAXPATHLEN];
+    char command[MAXPATHLEN+512];
+    char ext[16];
+    sprintf(command, "/bin/false");
+
     // append appropriate suffix for file type
-    safe_strcat(path, suffix[compression_type]);
+    sprintf(ext, ".xml%s", suffix[compression_type]);
+    archive_path(filename_prefix, ext, path);
 
     // and construct appropriate command if needed
     if (compression_type == COMPRESSION_GZIP) {
@@ -316,7 +357,9 @@ void open_archive(const char* filename_prefix, void*& f){
 
     log_messages.printf(MSG_NORMAL, "Opening archive %s\n", path);
 
-    if (compression_type == COMPRESSION_NONE) {
+    if (compression_type == COMPRESSION_NONE
+        || compression_type == COMPRESSION_COLUMNAR
+    ) {
         if (!(f = fopen(path,"w"))) {
             char buf[256];
             sprintf(buf, "Can't open archive file %s %s\n",
@@ -344,19 +387,15 @@ void open_archive(const char* filename_prefix, void*& f){
         }
     }
 
-    if (compression_type != COMPRESSION_ZLIB) {
-        //
-        // set buffering to line buffered, since we are outputing XML on a
-        // line-by-line basis.
-        //
-        setlinebuf((FILE*)f);
-    }
+    // The archives are fully buffered;
+    // flush_archives() is called before records are deleted from the DB.
 
     return;
 }
 
 void close_archive(const char *filename, void*& fp){
     char path[MAXPATHLEN];
+    char ext[16];
 
     // Set file pointer to NULL after closing file to indicate that it's closed.
     //
@@ -364,7 +403,9 @@ void close_archive(const char *filename, void*& fp){
 
     // In case of errors, carry on anyway.  This is deliberate, not lazy
     //
-    if (compression_type == COMPRESSION_NONE) {
+    if (compression_type == COMPRESSION_NONE
+        || compression_type == COMPRESSION_COLUMNAR
+    ) {
         fclose((FILE*)fp);
     } else if (compression_type == COMPRESSION_ZLIB) {
         gzclose((gzFile)fp);
@@ -375,22 +416,8 @@ void close_archive(const char *filename, void*& fp){
     fp = NULL;
 
     // reconstruct the filename
-    if (daily_dir) {
-        time_t time_time = time_int;
-        char dirname[32];
-        strftime(dirname, sizeof(dirname), "%Y_%m_%d", gmtime(&time_time));
-        safe_strcpy(path,
-            config.project_path(
-                  "archives/%s/%s_%d.xml", dirname, filename, time_int
-            )
-        );
-    } else {
-        safe_strcpy(path,
-            config.project_path("archives/%s_%d.xml", filename, time_int)
-        );
-    }
-    // append appropriate file type
-    safe_strcat(path, suffix[compression_type]);
+    sprintf(ext, ".xml%s", suffix[compression_type]);
+    archive_path(filename, ext, path);
 
     log_messages.printf(MSG_NORMAL,
         "Closed archive file %s containing records of %d workunits\n",
@@ -400,6 +427,38 @@ void close_archive(const char *filename, void*& fp){
     return;
 }
 
+void open_col_archive(
+    const char* filename_prefix, COL_ARCHIVE_WRITER& w,
+    COL_ARCHIVE_COLUMN* cols, int ncols
+) {
+    char path[MAXPATHLEN];
+    archive_path(filename_prefix, ".col", path);
+    log_messages.printf(MSG_NORMAL, "Opening archive %s\n", path);
+    if (w.open(path, cols, ncols)) {
+        char buf[256];
+        sprintf(buf, "Can't open archive file %s %s\n",
+            path, errno?strerror(errno):""
+        );
+        fail(buf);
+    }
+}
+
+void close_col_archive(const char* filename_prefix, COL_ARCHIVE_WRITER& w) {
+    char path[MAXPATHLEN];
+    if (!w.f) return;
+    archive_path(filename_prefix, ".col", path);
+    if (w.close()) {
+        log_messages.printf(MSG_CRITICAL,
+            "Error closing archive file %s\n", path
+        );
+        return;
+    }
+    log_messages.printf(MSG_NORMAL,
+        "Closed archive file %s containing records of %d workunits\n",
+        path, wu_stored_in_file
+    );
+}
+
 // opens the various archive files.  Guarantees that the timestamp
 // does not equal the previous timestamp
 //
@@ -412,11 +471,26 @@ void open_all_archives() {
         sleep(1);
     }
 
+    if (daily_dir) {
+        make_daily_dir();
+    }
+
     // open all the archives.
-    open_archive(WU_FILENAME_PREFIX, wu_stream);
-    open_archive(RESULT_FILENAME_PREFIX, re_stream);
     open_archive(RESULT_INDEX_FILENAME_PREFIX, re_index_stream);
     open_archive(WU_INDEX_FILENAME_PREFIX, wu_index_stream);
+    if (compression_type == COMPRESSION_COLUMNAR) {
+        open_col_archive(
+            WU_FILENAME_PREFIX, wu_col_archive,
+            wu_archive_columns, n_wu_archive_columns
+        );
+        open_col_archive(
+            RESULT_FILENAME_PREFIX, re_col_archive,
+            result_archive_columns, n_result_archive_columns
+        );
+        return;
+    }
+    open_archive(WU_FILENAME_PREFIX, wu_stream);
+    open_archive(RESULT_FILENAME_PREFIX, re_stream);
     if (compression_type == COMPRESSION_ZLIB) {
         gzprintf((gzFile)wu_stream, "<archive>\n");
         gzprintf((gzFile)re_stream, "<archive>\n");
@@ -434,12 +508,14 @@ void close_all_archives() {
     if (compression_type == COMPRESSION_ZLIB) {
         if (wu_stream) gzprintf((gzFile)wu_stream, "</archive>\n");
         if (re_stream) gzprintf((gzFile)re_stream, "</archive>\n");
-    } else {
+    } else if (compression_type != COMPRESSION_COLUMNAR) {
         if (wu_stream) fprintf((FILE*)wu_stream, "</archive>\n");
         if (re_stream) fprintf((FILE*)re_stream, "</archive>\n");
     }
     close_archive(WU_FILENAME_PREFIX, wu_stream);
     close_archive(RESULT_FILENAME_PREFIX, re_stream);
+    close_col_archive(WU_FILENAME_PREFIX, wu_col_archive);
+    close_col_archive(RESULT_FILENAME_PREFIX, re_col_archive);
     close_archive(RESULT_INDEX_FILENAME_PREFIX, re_index_stream);
     close_archive(WU_INDEX_FILENAME_PREFIX, wu_index_stream);
     log_messages.printf(MSG_NORMAL,
@@ -513,11 +589,6 @@ int archive_result_gz (DB_RESULT& result) {
         fail("ERROR: writing result archive failed\n");
     }
 
-    n = gzflush((gzFile)re_stream, Z_SYNC_FLUSH);
-    if (n != Z_OK) {
-        fail("ERROR: writing result archive failed (flush)\n");
-    }
-
     n = gzprintf((gzFile)re_index_stream,
         "%lu     %d    %s\n",
         result.id, time_int, result.name
@@ -526,11 +597,6 @@ int archive_result_gz (DB_RESULT& result) {
         fail("ERROR: writing result index failed\n");
     }
 
-    n = gzflush((gzFile)re_index_stream, Z_SYNC_FLUSH);
-    if (n != Z_OK) {
-        fail("ERROR: writing result index failed (flush)\n");
-    }
-
     return 0;
 }
 
@@ -547,11 +613,6 @@ int archive_wu_gz (DB_WORKUNIT& wu) {
         fail("ERROR: writing workunit archive failed\n");
     }
 
-    n = gzflush((gzFile)wu_stream,Z_SYNC_FLUSH);
-    if (n != Z_OK) {
-        fail("ERROR: writing workunit archive failed (flush)\n");
-    }
-
     n = gzprintf((gzFile)wu_index_stream,
         "%lu     %d    %s\n",
         wu.id, time_int, wu.name
@@ -560,55 +621,186 @@ int archive_wu_gz (DB_WORKUNIT& wu) {
         fail("ERROR: writing workunit index failed\n");
     }
 
-    n = gzflush((gzFile)wu_index_stream,Z_SYNC_FLUSH);
-    if (n != Z_OK) {
-        fail("ERROR: writing workunit index failed (flush)\n");
-    }
+    return 0;
+}
 
+int archive_result_col(DB_RESULT& result) {
+    re_col_archive.add_row((RESULT*)&result);
+    int n = fprintf((FILE*)re_index_stream,
+        "%lu     %d    %s\n",
+        result.id, time_int, result.name
+    );
+    if (n < 0) fail("archive_result_col: index fprintf() failed\n");
     return 0;
 }
 
-int purge_and_archive_results(DB_WORKUNIT& wu, int& number_results) {
-    int retval= 0;
+int archive_wu_col(DB_WORKUNIT& wu) {
+    wu_col_archive.add_row((WORKUNIT*)&wu);
+    int n = fprintf((FILE*)wu_index_stream,
+        "%lu     %d    %s\n",
+        wu.id, time_int, wu.name
+    );
+    if (n < 0) fail("archive_wu_col: index fprintf() failed\n");
+    return 0;
+}
+
+// write buffered archive data.
+// Do this before deleting the archived records from the DB.
+// In columnar format, each chunk becomes a block.
+//
+void flush_archives() {
+    if (compression_type == COMPRESSION_COLUMNAR) {
+        if (wu_col_archive.write_block()
+            || re_col_archive.write_block()
+            || fflush(NULL)
+        ) {
+            fail("ERROR: writing archive failed (flush)\n");
+        }
+    } else if (compression_type == COMPRESSION_ZLIB) {
+        if (gzflush((gzFile)wu_stream, Z_SYNC_FLUSH) != Z_OK
+            || gzflush((gzFile)re_stream, Z_SYNC_FLUSH) != Z_OK
+            || gzflush((gzFile)wu_index_stream, Z_SYNC_FLUSH) != Z_OK
+            || gzflush((gzFile)re_index_stream, Z_SYNC_FLUSH) != Z_OK
+        ) {
+            fail("ERROR: writing archive failed (flush)\n");
+        }
+    } else {
+        if (fflush(NULL)) {
+            fail("ERROR: writing archive failed (flush)\n");
+        }
+    }
+}
+
+// Archive and purge a chunk of WUs and their results.
+// This takes one query to get the results,
+// and one query per table to delete the records,
+// rather than one per record.
+//
+int purge_chunk(vector<DB_WORKUNIT>& wus, int& nresults) {
     DB_RESULT result;
+    string wu_ids, result_ids, clause;
     char buf[256];
+    int retval;
 
-    number_results=0;
+    nresults = 0;
+    for (unsigned int i=0; i<wus.size(); i++) {
+        if (i) wu_ids += ",";
+        sprintf(buf, "%lu", wus[i].id);
+        wu_ids += buf;
+    }
+
+    if (!no_archive && !wu_index_stream) {
+        open_all_archives();
+    }
 
-    sprintf(buf, "where workunitid=%lu", wu.id);
-    while (!result.enumerate(buf)) {
+    // get the results, streaming them since there may be a lot
+    //
+    clause = "where workunitid in (" + wu_ids + ")";
+    while (1) {
+        retval = result.enumerate(clause.c_str(), true);
+        if (retval) {
+            if (retval != ERR_DB_NOT_FOUND) {
+                log_messages.printf(MSG_CRITICAL,
+                    "result enumerate failed: %s\n", boinc_db.error_string()
+                );
+                return retval;
+            }
+            break;
+        }
         if (!no_archive) {
             if (compression_type == COMPRESSION_ZLIB) {
-                retval = archive_result_gz(result);
+                archive_result_gz(result);
+            } else if (compression_type == COMPRESSION_COLUMNAR) {
+                archive_result_col(result);
             } else {
-                retval = archive_result(result);
+                archive_result(result);
             }
-            if (retval) return retval;
             log_messages.printf(MSG_DEBUG,
                 "Archived result [%lu] to a file\n", result.id
             );
         }
-        if (dont_delete) {
+        if (nresults) result_ids += ",";
+        sprintf(buf, "%lu", result.id);
+        result_ids += buf;
+        nresults++;
+    }
+
+    if (!no_archive) {
+        for (DB_WORKUNIT& wu: wus) {
+            if (compression_type == COMPRESSION_ZLIB) {
+                archive_wu_gz(wu);
+            } else if (compression_type == COMPRESSION_COLUMNAR) {
+                archive_wu_col(wu);
+            } else {
+                archive_wu(wu);
+            }
             log_messages.printf(MSG_DEBUG,
-                "Didn't purge result [%lu] from database (-dont_delete)\n", result.id
+                "Archived workunit [%lu] to a file\n", wu.id
             );
-        } else {
-            retval = result.delete_from_db();
-            if (retval) {
-                log_messages.printf(MSG_CRITICAL,
-                    "Couldn't delete result [%lu] from database\n", result.id
-                );
-                return retval;
-            }
-            log_messages.printf(MSG_NORMAL,
-                "Purged result [%lu] batch %d\n", result.id, result.batch
+        }
+        flush_archives();
+    }
+
+    if (dont_delete) {
+        log_messages.printf(MSG_DEBUG,
+            "Didn't purge %d workunits and %d results from database (--dont_delete)\n",
+            (int)wus.size(), nresults
+        );
+        return 0;
+    }
+
+    // delete results first;
+    // if that fails, leave the WUs so the results don't get orphaned
+    //
+    if (nresults) {
+        clause = "id in (" + result_ids + ")";
+        retval = result.delete_from_db_multi(clause.c_str());
+        if (retval) {
+            log_messages.printf(MSG_CRITICAL,
+                "Couldn't delete %d results from database: %s\n",
+                nresults, boinc_db.error_string()
             );
+            return retval;
         }
-        number_results++;
     }
+    clause = "id in (" + wu_ids + ")";
+    retval = wus[0].delete_from_db_multi(clause.c_str());
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "Can't delete %d workunits from database: %s\n",
+            (int)wus.size(), boinc_db.error_string()
+        );
+        exit(6);
+    }
+    if (config.enable_assignment) {
+        DB_ASSIGNMENT asg;
+        clause = "workunitid in (" + wu_ids + ")";
+        asg.delete_from_db_multi(clause.c_str());
+    }
+    for (DB_WORKUNIT& wu: wus) {
+        log_messages.printf(MSG_NORMAL,
+            "Purged workunit [%lu] batch %d\n", wu.id, wu.batch
+        );
+    }
+    log_messages.printf(MSG_DEBUG,
+        "Purged %d results: %s\n", nresults, result_ids.c_str()
+    );
     return 0;
 }
 
+// how many WUs to put in the next chunk
+//
+int chunk_limit() {
+    int n = PURGE_CHUNK_SIZE;
+    if (!no_archive && max_wu_per_file) {
+        n = std::min(n, max_wu_per_file - wu_stored_in_file);
+    }
+    if (max_number_workunits_to_purge) {
+        n = std::min(n, max_number_workunits_to_purge - purged_workunits);
+    }
+    return n;
+}
+
 // get list of IDs of retired batches (and 0, = no batch)
 //
 int get_retired_batch_ids(string &out) {
@@ -689,8 +881,11 @@ bool do_pass(string &retired_batch_ids) {
     sprintf(buf, " limit %d", DB_QUERY_LIMIT);
     clause += buf;
 
-    int n=0;
-    while (1) {
+    double start_time = dtime();
+    vector<DB_WORKUNIT> wus;
+    bool enum_done = false;
+    int n;
+    while (!enum_done) {
         retval = wu.enumerate(clause.c_str());
         if (retval) {
             if (retval != ERR_DB_NOT_FOUND) {
@@ -699,92 +894,49 @@ bool do_pass(string &retired_batch_ids) {
                 );
                 exit(0);
             }
-            break;
+            enum_done = true;
+        } else {
+            if (strstr(wu.name, "nodelete")) continue;
+            did_something = true;
+            wus.push_back(wu);
+            if ((int)wus.size() < chunk_limit()) continue;
         }
-        if (strstr(wu.name, "nodelete")) continue;
-        did_something = true;
+        if (wus.empty()) continue;
 
-        // if archives have not already been opened, then open them.
-        //
-        if (!no_archive && !wu_stream) {
-            open_all_archives();
+        retval = purge_chunk(wus, n);
+        if (retval) {
+            // rows we couldn't delete will be tried again next pass
+            //
+            if (!enum_done) wu.end_enumerate();
+            break;
         }
 
-        retval = purge_and_archive_results(wu, n);
-        // if a result fails to be deleted, don't purge this workunit,
-        // or this result will be left orphaned and never get deleted
-        if (retval) continue;
-
+        purged_workunits += (int)wus.size();
+        do_pass_purged_workunits += (int)wus.size();
         do_pass_purged_results += n;
+        wu_stored_in_file += (int)wus.size();
+        wus.clear();
 
-        if (!no_archive) {
-            if (compression_type == COMPRESSION_ZLIB) {
-                retval= archive_wu_gz(wu);
-            } else {
-                retval= archive_wu(wu);
-            }
-            if (retval) {
-                log_messages.printf(MSG_CRITICAL,
-                    "Failed to write to XML file workunit:%lu\n", wu.id
-                );
-                exit(5);
-            }
-            log_messages.printf(MSG_DEBUG,
-                "Archived workunit [%lu] to a file\n", wu.id
-            );
-        }
-
-        // purge workunit from DB
+        // if file has got max # of workunits, close and compress it.
+        // This sets file pointers to NULL
         //
-        if (dont_delete) {
-            log_messages.printf(MSG_DEBUG,
-                "Didn't purge workunit [%lu] from database (--dont_delete)\n", wu.id
-            );
-        } else {
-            retval= wu.delete_from_db();
-            if (retval) {
-                log_messages.printf(MSG_CRITICAL,
-                    "Can't delete workunit [%lu] from database: %d\n",
-                    wu.id, retval
-                );
-                exit(6);
-            }
-            if (config.enable_assignment) {
-                DB_ASSIGNMENT asg;
-                sprintf(buf, "workunitid=%lu", wu.id);
-                asg.delete_from_db_multi(buf);
-            }
-            log_messages.printf(MSG_NORMAL,
-                "Purged workunit [%lu] batch %d\n", wu.id, wu.batch
-            );
-        }
-
-        purged_workunits++;
-        do_pass_purged_workunits++;
-        wu_stored_in_file++;
-
-        if (!no_archive) {
-            fflush(NULL);
-
-            // if file has got max # of workunits, close and compress it.
-            // This sets file pointers to NULL
-            //
-            if (max_wu_per_file && wu_stored_in_file>=max_wu_per_file) {
-                close_all_archives();
-                wu_stored_in_file = 0;
-            }
+        if (!no_archive && max_wu_per_file && wu_stored_in_file>=max_wu_per_file) {
+            close_all_archives();
+            wu_stored_in_file = 0;
         }
 
         if (time_to_quit()) {
+            if (!enum_done) wu.end_enumerate();
             break;
         }
-
     }
 
     if (do_pass_purged_workunits) {
+        double dt = dtime() - start_time;
         log_messages.printf(MSG_NORMAL,
-            "Archived %d workunits and %d results\n",
-            do_pass_purged_workunits, do_pass_purged_results
+            "Archived %d workunits and %d results in %.1f sec (%.0f rows/sec)\n",
+            do_pass_purged_workunits, do_pass_purged_results, dt,
+            (do_pass_purged_workunits+do_pass_purged_results)/std::max(dt, .001)
         );
     }
 
@@ -850,6 +1002,8 @@ int main(int argc, char** argv) {
             compression_type=COMPRESSION_GZIP;
         } else if (is_arg(argv[i], "zlib")) {
             compression_type=COMPRESSION_ZLIB;
+        } else if (is_arg(argv[i], "columnar")) {
+            compression_type=COMPRESSION_COLUMNAR;
         } else if (is_arg(argv[i], "max_wu_per_file")) {
             if(!argv[++i]) {
                 log_messages.printf(MSG_CRITICAL, "%s requires an argument\n\n", argv[--i]);
@@ -890,6 +1044,14 @@ int main(int argc, char** argv) {
             }
             id_modulus   = atoi(argv[++i]);
             id_remainder = atoi(argv[++i]);
+        } else if (is_arg(argv[i], "nprocs")) {
+            if (!argv[++i]) {
+                log_messages.printf(MSG_CRITICAL, "%s requires an argument\n\n", argv[--i]);
+                usage();
+                exit(1);
+            }
+            nprocs = atoi(argv[i]);
+            if (nprocs < 1) nprocs = 1;
         } else if (is_arg(argv[i], "app")) {
             safe_strcpy(app_name, argv[++i]);
         } else {
@@ -908,6 +1070,13 @@ int main(int argc, char** argv) {
         usage();
         exit(1);
     }
+    if (nprocs > 1 && (id_modulus || !no_archive)) {
+        log_messages.printf(MSG_CRITICAL,
+            "--nprocs requires --no_archive, and can't be used with --mod\n\n"
+        );
+        usage();
+        exit(1);
+    }
 
     retval = config.parse_file();
     if (retval) {
@@ -919,6 +1088,37 @@ int main(int argc, char** argv) {
 
     log_messages.printf(MSG_NORMAL, "Starting\n");
 
+    // if --nprocs, fork processes that each purge WUs with
+    // ID mod nprocs == i, with their own DB connection.
+    //
+    if (nprocs > 1) {
+        if (max_number_workunits_to_purge) {
+            max_number_workunits_to_purge =
+                (max_number_workunits_to_purge + nprocs - 1)/nprocs;
+        }
+        for (i=0; i<nprocs; i++) {
+            pid_t pid = fork();
+            if (pid < 0) {
+                log_messages.printf(MSG_CRITICAL, "fork() failed\n");
+                exit(1);
+            }
+            if (pid == 0) {
+                id_modulus = nprocs;
+                id_remainder = i;
+                log_messages.pid = getpid();
+                break;
+            }
+        }
+        if (!id_modulus) {
+            int status, nfailed = 0;
+            for (i=0; i<nprocs; i++) {
+                if (wait(&status) < 0) break;
+                if (!WIFEXITED(status) || WEXITSTATUS(status)) nfailed++;
+            }
+            exit(nfailed?1:0);
+        }
+    }
+
     retval = boinc_db.open(
         config.db_name, config.db_host, config.db_user, config.db_passwd
     );
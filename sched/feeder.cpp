@@ -45,8 +45,9 @@
 // scan_work_array() scans the work array.
 // looking for empty slots and trying to fill them in.
 // The enumeration may return results already in the array.
-// So, for each result, we scan the entire array to make sure
-// it's not there already (can this be streamlined?)
+// So, for each result, we look it up in a hash table
+// mapping result ID to slot (rebuilt at the start of each array scan)
+// to make sure it's not there already.
 //
 // The length of the enum (max and actual) and the number of empty
 // slots may differ; either one may be larger.
@@ -89,11 +90,17 @@
 // reread_db:    update DB contents in existing shmem
 //               delete trigger file
 
+// The platform, app, app version and assignment tables in shared memory
+// are sized based on the DB contents when the feeder starts.
+// If you add rows (e.g. app versions) and the tables overflow on reread_db,
+// restart the feeder.
+//
 // If you get an "Invalid argument" error when trying to run the feeder,
 // it is likely that you aren't able to allocate enough shared memory.
 // Either increase the maximum shared memory segment size in the kernel
 // configuration, or decrease the MAX_PLATFORMS, MAX_APPS
-// MAX_APP_VERSIONS, and MAX_WU_RESULTS in sched_shmem.h
+// MAX_APP_VERSIONS (the number of spare rows in each table)
+// in sched_shmem.h, or <shmem_work_items> in config.xml
 
 #include "config.h"
 #include <cstdio>
@@ -108,7 +115,9 @@
 #include <sys/stat.h>
 #include <sys/param.h>
 #include <vector>
+#include <unordered_map>
 using std::vector;
+using std::unordered_map;
 
 #include "boinc_db.h"
 #include "error_numbers.h"
@@ -140,6 +149,7 @@ using std::vector;
 #define ENUM_OVER           2
 
 SCHED_SHMEM* ssp;
+SCHED_SHMEM_SIZES shmem_sizes;
 key_t sema_key;
 const char* order_clause="";
 char mod_select_clause[256];
@@ -163,6 +173,11 @@ bool using_hr;
 bool is_main_feeder = true;
     // false if using --mod or --wmod and this one isn't 0
 
+unordered_map<DB_ID_TYPE, int> result_slots;
+    // maps result ID to slot for results in the work array.
+    // Schedulers empty slots without telling us,
+    // so an entry may be stale; check the slot before believing it.
+
 void signal_handler(int) {
     log_messages.printf(MSG_NORMAL, "Signaled by simulator\n");
     return;
@@ -183,7 +198,7 @@ int check_reread_trigger() {
             "Found trigger file %s; re-scanning database tables.\n",
             REREAD_DB_FILENAME
         );
-        ssp->init(num_work_items);
+        ssp->clear_tables();
         ssp->scan_tables();
         ssp->perf_info.get_from_db();
         int retval = unlink(config.project_path(REREAD_DB_FILENAME));
@@ -327,7 +342,9 @@ static bool get_job_from_db(
             // Check for collision (i.e. this result already is in the array)
             //
             collision = false;
-            for (j=0; j<ssp->max_wu_results; j++) {
+            auto rs = result_slots.find(wi.res_id);
+            if (rs != result_slots.end()) {
+                j = rs->second;
                 if (ssp->wu_results[j].state != WR_STATE_EMPTY && ssp->wu_results[j].resultid == wi.res_id) {
                     // If the result is already in shared mem,
                     // and another instance of the WU has been sent,
@@ -344,7 +361,6 @@ static bool get_job_from_db(
                     log_messages.printf(MSG_DEBUG,
                         "result [RESULT#%lu] already in array\n", wi.res_id
                     );
-                    break;
                 }
             }
             if (collision) {
@@ -475,6 +491,14 @@ static bool scan_work_array(vector<DB_WORK_ITEM> &work_items) {
         hr_count_slots();
     }
 
+    result_slots.clear();
+    for (i=0; i<ssp->max_wu_results; i++) {
+        WU_RESULT& wu_result = ssp->wu_results[i];
+        if (wu_result.state != WR_STATE_EMPTY) {
+            result_slots[wu_result.resultid] = i;
+        }
+    }
+
     for (i=0; i<ssp->max_wu_results; i++) {
         app_index = app_indices[i];
 
@@ -487,8 +511,12 @@ static bool scan_work_array(vector<DB_WORK_ITEM> &work_items) {
                     "remove result [RESULT#%lu] from slot %d because it is stale\n",
                     wu_result.resultid, i
                 );
+                // a scheduler may reserve it while we're looking at it
+                //
+                if (!wu_result.change_state(WR_STATE_PRESENT, WR_STATE_EMPTY)) {
+                    break;
+                }
                 purge_stale(wu_result);
-                wu_result.state = WR_STATE_EMPTY;
                 // fall through, refill this array slot
             } else {
                 break;
@@ -508,7 +536,6 @@ static bool scan_work_array(vector<DB_WORK_ITEM> &work_items) {
                 wu_result.res_server_state = wi.res_server_state;
                 wu_result.res_report_deadline = wi.res_report_deadline;
                 wu_result.workunit = wi.wu;
-                wu_result.state = WR_STATE_PRESENT;
                 // If the workunit has already been allocated to a certain
                 // OS then it should be assigned quickly,
                 // so we set its infeasible_count to 1
@@ -525,6 +552,12 @@ static bool scan_work_array(vector<DB_WORK_ITEM> &work_items) {
                     wu_result.need_reliable = true;
                 }
                 wu_result.time_added_to_shared_memory = time(0);
+
+                // make the slot visible to schedulers
+                // only after it's completely filled in
+                //
+                wu_result.change_state(WR_STATE_EMPTY, WR_STATE_PRESENT);
+                result_slots[wi.res_id] = i;
                 nadditions++;
             }
             break;
@@ -537,7 +570,7 @@ static bool scan_work_array(vector<DB_WORK_ITEM> &work_items) {
             sprintf(buf, "/proc/%d", pid);
             log_messages.printf(MSG_NORMAL, "checking pid %d\n", pid);
             if (stat(buf, &s)) {
-                wu_result.state = WR_STATE_PRESENT;
+                wu_result.change_state(pid, WR_STATE_PRESENT);
                 log_messages.printf(MSG_NORMAL,
                     "Result reserved by non-existent process PID %d; resetting\n",
                     pid
@@ -851,39 +884,63 @@ int main(int argc, char** argv) {
     destroy_semaphore(sema_key);
     create_semaphore(sema_key);
 
+    retval = boinc_db.open(
+        config.db_name, config.db_host, config.db_user, config.db_passwd
+    );
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "boinc_db.open: %d; %s\n", retval, boinc_db.error_string()
+        );
+        exit(1);
+    }
+    retval = boinc_db.set_isolation_level(READ_UNCOMMITTED);
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "boinc_db.set_isolation_level: %d; %s\n", retval, boinc_db.error_string()
+        );
+    }
+
+    // size the tables based on the DB contents
+    //
+    retval = shmem_sizes.get_from_db(num_work_items);
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "can't get shmem table sizes: %s\n", boincerror(retval)
+        );
+        exit(1);
+    }
+    log_messages.printf(MSG_NORMAL,
+        "shmem table sizes: "
+        "%d platforms, "
+        "%d apps, "
+        "%d app_versions, "
+        "%d assignments, "
+        "%d job slots\n",
+        shmem_sizes.max_platforms,
+        shmem_sizes.max_apps,
+        shmem_sizes.max_app_versions,
+        shmem_sizes.max_assignments,
+        shmem_sizes.max_wu_results
+    );
+
     retval = destroy_shmem(config.shmem_key);
     if (retval) {
         log_messages.printf(MSG_CRITICAL, "can't destroy shmem\n");
         exit(1);
     }
 
-    int shmem_size = sizeof(SCHED_SHMEM) + num_work_items*sizeof(WU_RESULT);
+    int shmem_size = (int)shmem_sizes.segment_size();
     retval = create_shmem(config.shmem_key, shmem_size, 0 /* don't set GID */, &p);
     if (retval) {
         log_messages.printf(MSG_CRITICAL, "can't create shmem\n");
         exit(1);
     }
     ssp = (SCHED_SHMEM*)p;
-    ssp->init(num_work_items);
+    ssp->init(shmem_sizes);
 
     atexit(cleanup_shmem);
     install_stop_signal_handler();
 
-    retval = boinc_db.open(
-        config.db_name, config.db_host, config.db_user, config.db_passwd
-    );
-    if (retval) {
-        log_messages.printf(MSG_CRITICAL,
-            "boinc_db.open: %d; %s\n", retval, boinc_db.error_string()
-        );
-        exit(1);
-    }
-    retval = boinc_db.set_isolation_level(READ_UNCOMMITTED);
-    if (retval) {
-        log_messages.printf(MSG_CRITICAL,
-            "boinc_db.set_isolation_level: %d; %s\n", retval, boinc_db.error_string()
-        );
-    }
     ssp->scan_tables();
 
     log_messages.printf(MSG_NORMAL,
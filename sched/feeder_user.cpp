@@ -94,6 +94,7 @@ struct JOB_STREAM {
 vector<JOB_STREAM> job_streams;
 
 SCHED_SHMEM* ssp;
+SCHED_SHMEM_SIZES shmem_sizes;
 key_t sema_key;
 int sleep_interval = SLEEP_INTERVAL;
 int num_work_items = MAX_WU_RESULTS;
@@ -116,7 +117,7 @@ int check_reread_trigger() {
             "Found trigger file %s; re-scanning database tables.\n",
             REREAD_DB_FILENAME
         );
-        ssp->init(num_work_items);
+        ssp->clear_tables();
         ssp->scan_tables();
         ssp->perf_info.get_from_db();
         int retval = unlink(config.project_path(REREAD_DB_FILENAME));
@@ -237,10 +238,10 @@ bool JOB_STREAM::scan_result_set(WU_RESULT &wu_result) {
             wu_result.res_server_state = wi.res_server_state;
             wu_result.res_report_deadline = wi.res_report_deadline;
             wu_result.workunit = wi.wu;
-            wu_result.state = WR_STATE_PRESENT;
             wu_result.infeasible_count = 0;
             wu_result.need_reliable = false;
             wu_result.time_added_to_shared_memory = time(0);
+            wu_result.change_state(WR_STATE_EMPTY, WR_STATE_PRESENT);
             usage += inv_share;
             if (usage > max_usage) {
                 double d = usage - max_usage;
@@ -300,7 +301,9 @@ static bool scan_work_array() {
                     "removing stale result [RESULT#%lu] from slot %d\n",
                     wu_result.resultid, i
                 );
-                wu_result.state = WR_STATE_EMPTY;
+                if (!wu_result.change_state(WR_STATE_PRESENT, WR_STATE_EMPTY)) {
+                    continue;
+                }
             } else {
                 continue;
             }
@@ -322,7 +325,7 @@ static bool scan_work_array() {
             sprintf(buf, "/proc/%d", pid);
             log_messages.printf(MSG_NORMAL, "checking pid %d\n", pid);
             if (stat(buf, &s)) {
-                wu_result.state = WR_STATE_PRESENT;
+                wu_result.change_state(pid, WR_STATE_PRESENT);
                 log_messages.printf(MSG_NORMAL,
                     "Result reserved by non-existent process PID %d; resetting\n",
                     pid
@@ -483,13 +486,52 @@ void feeder_init() {
     destroy_semaphore(sema_key);
     create_semaphore(sema_key);
 
+    retval = boinc_db.open(
+        config.db_name, config.db_host, config.db_user, config.db_passwd
+    );
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "boinc_db.open: %d; %s\n", retval, boinc_db.error_string()
+        );
+        exit(1);
+    }
+    retval = boinc_db.set_isolation_level(READ_UNCOMMITTED);
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "boinc_db.set_isolation_level: %d; %s\n", retval, boinc_db.error_string()
+        );
+    }
+
+    // size the tables based on the DB contents
+    //
+    retval = shmem_sizes.get_from_db(num_work_items);
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "can't get shmem table sizes: %s\n", boincerror(retval)
+        );
+        exit(1);
+    }
+    log_messages.printf(MSG_NORMAL,
+        "shmem table sizes: "
+        "%d platforms, "
+        "%d apps, "
+        "%d app_versions, "
+        "%d assignments, "
+        "%d job slots\n",
+        shmem_sizes.max_platforms,
+        shmem_sizes.max_apps,
+        shmem_sizes.max_app_versions,
+        shmem_sizes.max_assignments,
+        shmem_sizes.max_wu_results
+    );
+
     retval = destroy_shmem(config.shmem_key);
     if (retval) {
         log_messages.printf(MSG_CRITICAL, "can't destroy shmem\n");
         exit(1);
     }
 
-    int shmem_size = sizeof(SCHED_SHMEM) + num_work_items*sizeof(WU_RESULT);
+    int shmem_size = (int)shmem_sizes.segment_size();
     void *p;
     retval = create_shmem(config.shmem_key, shmem_size, 0 /* don't set GID */, &p);
     if (retval) {
@@ -497,25 +539,10 @@ void feeder_init() {
         exit(1);
     }
     ssp = (SCHED_SHMEM*)p;
-    ssp->init(num_work_items);
+    ssp->init(shmem_sizes);
 
     atexit(cleanup_shmem);
 
-    retval = boinc_db.open(
-        config.db_name, config.db_host, config.db_user, config.db_passwd
-    );
-    if (retval) {
-        log_messages.printf(MSG_CRITICAL,
-            "boinc_db.open: %d; %s\n", retval, boinc_db.error_string()
-        );
-        exit(1);
-    }
-    retval = boinc_db.set_isolation_level(READ_UNCOMMITTED);
-    if (retval) {
-        log_messages.printf(MSG_CRITICAL,
-            "boinc_db.set_isolation_level: %d; %s\n", retval, boinc_db.error_string()
-        );
-    }
     ssp->scan_tables();
 
     retval = ssp->perf_info.get_from_db();
@@ -32,8 +32,21 @@
 //
 #define ERROR_INTERVAL      3600
 
+// max # of files waiting for a worker thread
+//
+#define DELETE_QUEUE_SIZE   1000
+
+// max # of IDs per file_delete_state update
+//
+#define FILE_DELETE_UPDATE_BATCH    1000
+
 #include "config.h"
 #include <list>
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <cstdlib>
@@ -44,6 +57,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/resource.h>
+#include <pthread.h>
 #if HAVE_STRINGS_H
 #include <strings.h>
 #endif
@@ -63,6 +77,10 @@
 #include "sched_msgs.h"
 
 using std::string;
+using std::vector;
+using std::deque;
+using std::map;
+using std::set;
 
 #define LOCKFILE "file_deleter.out"
 #define PIDFILE  "file_deleter.pid"
@@ -109,6 +127,8 @@ void usage(char *name) {
         "  --output_files_only          delete only output (upload) files\n"
         "  --xml_doc_like L             only process workunits where xml_doc LIKE 'L'\n"
         "  --download_dir D             override download_dir from project config with D\n"
+        "  --nthreads N                 delete files using N threads\n"
+        "                               (useful if the upload/download dirs are on a network FS)\n"
         "  [ -h | --help ]              shows this help text\n"
         "  [ -v | --version ]           shows version information\n",
         name
@@ -137,112 +157,264 @@ int get_file_path(
 }
 
 
-int wu_delete_files(WORKUNIT& wu) {
+// A file to delete, and the outcome.
+// Finding and unlinking the file is slow on network file systems,
+// so with --nthreads it's done by a pool of worker threads.
+// The main thread does the logging and DB updates.
+//
+struct DELETE_JOB {
+    int irec;
+        // index in the pass's list of records
+    bool is_wu;
+        // input file (else output file)
+    string filename;
     char path[MAXPATHLEN];
-    char path_gz[MAXPATHLEN], path_md5[MAXPATHLEN];
-    bool no_delete=false;
-    int count_deleted = 0, retval, mthd_retval = 0;
+    int retval;
+        // from get_file_path(), or ERR_UNLINK
+    int unlink_errno;
+    bool deleted_gz;
+    int md5_retval;
+};
 
-    if (strstr(wu.name, "nodelete")) return 0;
+// a WU or result whose files are being deleted
+//
+struct DELETE_REC {
+    DB_ID_TYPE id;
+    int file_delete_state;
+    int outcome;
+    int client_state;
+    int ndeleted;
+    int retval;
+    set<string> failed;
+        // files we couldn't delete
+};
 
-    MIOFILE mf;
-    mf.init_buf_read(wu.xml_doc);
-    XML_PARSER xp(&mf);
+// files we couldn't delete, per WU and result.
+// When we retry a record in FILE_DELETE_ERROR state,
+// only these files are retried.
+// If a record isn't here (e.g. we were restarted) all its files are.
+//
+map<DB_ID_TYPE, set<string> > wu_failed_files, result_failed_files;
+
+int nthreads = 0;
+pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t job_ready = PTHREAD_COND_INITIALIZER;
+pthread_cond_t job_taken = PTHREAD_COND_INITIALIZER;
+pthread_cond_t job_done = PTHREAD_COND_INITIALIZER;
+deque<DELETE_JOB*> pending_jobs, done_jobs;
+int njobs_running = 0;
+    // queued or being done; not yet in done_jobs
+
+// find and delete a file (and related files).
+// This may run in a worker thread, so don't log anything.
+//
+void do_delete_job(DELETE_JOB& job) {
+    char path2[MAXPATHLEN];
+
+    job.unlink_errno = 0;
+    job.deleted_gz = false;
+    job.md5_retval = 0;
+    job.retval = get_file_path(
+        job.filename.c_str(),
+        job.is_wu?download_dir:config.upload_dir,
+        config.uldl_dir_fanout, job.path
+    );
+    if (job.retval) return;
+    if (unlink(job.path)) {
+        job.retval = ERR_UNLINK;
+        job.unlink_errno = errno;
+    }
+    if (job.is_wu) {
+        // delete the gzipped version of the file
+        //
+        snprintf(path2, sizeof(path2), "%s.gz", job.path);
+        job.deleted_gz = !unlink(path2);
+
+        // delete the cached MD5 file if needed
+        //
+        if (config.cache_md5_info) {
+            snprintf(path2, sizeof(path2), "%s.md5", job.path);
+            job.md5_retval = unlink(path2);
+        }
+    } else if (!job.retval && config.fuh_md5_info) {
+        // MD5 written by the upload handler, if any
+        //
+        snprintf(path2, sizeof(path2), "%s.md5", job.path);
+        unlink(path2);
+    }
+}
 
-    while (!xp.get_tag()) {
-        if (!xp.is_tag) continue;
-        if (xp.match_tag("file_info")) {
-            string filename;
-            no_delete = false;
-            while (!xp.get_tag()) {
-                if (xp.parse_string("name", filename)) {
-                    continue;
-                } else if (xp.parse_bool("no_delete", no_delete)) {
-                    continue;
-                } else if (xp.match_tag("/file_info")) {
-                    break;
-                }
-            }
-            if (!xp.match_tag("/file_info") || filename.empty()) {
-                log_messages.printf(MSG_CRITICAL, "bad WU XML: %s\n",
-                    wu.xml_doc
-                );
+void* delete_worker(void*) {
+    while (1) {
+        pthread_mutex_lock(&queue_mutex);
+        while (pending_jobs.empty()) {
+            pthread_cond_wait(&job_ready, &queue_mutex);
+        }
+        DELETE_JOB* job = pending_jobs.front();
+        pending_jobs.pop_front();
+        pthread_cond_signal(&job_taken);
+        pthread_mutex_unlock(&queue_mutex);
+
+        do_delete_job(*job);
+
+        pthread_mutex_lock(&queue_mutex);
+        done_jobs.push_back(job);
+        pthread_cond_signal(&job_done);
+        pthread_mutex_unlock(&queue_mutex);
+    }
+    return NULL;
+}
+
+void start_delete_workers() {
+    for (int i=0; i<nthreads; i++) {
+        pthread_t thread;
+        int retval = pthread_create(&thread, NULL, delete_worker, NULL);
+        if (retval) {
+            log_messages.printf(MSG_CRITICAL,
+                "can't create thread: %s\n", strerror(retval)
+            );
+            exit(1);
+        }
+        pthread_detach(thread);
+    }
+}
+
+// log the outcome of a deletion, and record it in the WU or result
+//
+void finish_job(DELETE_JOB* job, vector<DELETE_REC>& recs) {
+    DELETE_REC& rec = recs[job->irec];
+    const char* fname = job->filename.c_str();
+    int retval = 0;
+
+    if (job->is_wu) {
+        if (job->retval == ERR_OPENDIR) {
+            log_messages.printf(MSG_CRITICAL,
+                "[WU#%lu] missing dir for %s\n", rec.id, fname
+            );
+            retval = ERR_UNLINK;
+        } else if (job->retval == ERR_UNLINK) {
+            log_messages.printf(MSG_CRITICAL,
+                "[WU#%lu] unlink %s failed: %s\n",
+                rec.id, fname, strerror(job->unlink_errno)
+            );
+            retval = ERR_UNLINK;
+        } else if (job->retval) {
+            log_messages.printf(MSG_CRITICAL,
+                "[WU#%lu] get_file_path: %s: %s\n",
+                rec.id, fname, boincerror(job->retval)
+            );
+        } else {
+            log_messages.printf(MSG_NORMAL,
+                "[WU#%lu] deleted %s\n", rec.id, fname
+            );
+            rec.ndeleted++;
+        }
+        if (job->deleted_gz) {
+            log_messages.printf(MSG_NORMAL,
+                "[WU#%lu] deleted %s.gz\n", rec.id, fname
+            );
+        }
+        if (job->md5_retval) {
+            log_messages.printf(MSG_CRITICAL,
+                "[WU#%lu] unlink %s.md5 failed\n", rec.id, fname
+            );
+        }
+    } else {
+        if (job->retval == ERR_OPENDIR) {
+            log_messages.printf(MSG_CRITICAL,
+                "[RESULT#%lu] missing dir for %s\n", rec.id, job->path
+            );
+            retval = ERR_OPENDIR;
+        } else if (job->retval == ERR_UNLINK) {
+            log_messages.printf(MSG_CRITICAL,
+                "[RESULT#%lu] unlink %s error: %s\n",
+                rec.id, job->path, strerror(job->unlink_errno)
+            );
+            retval = ERR_UNLINK;
+        } else if (job->retval) {
+            // the fact that no result files were found is a critical
+            // error if this was a successful result,
+            // but is to be expected if the result outcome was failure,
+            // since in that case no output file may have been produced.
+            //
+            int msg_mode;
+            if (RESULT_OUTCOME_SUCCESS == rec.outcome) {
+                msg_mode = MSG_CRITICAL;
+            } else {
+                msg_mode = MSG_DEBUG;
             }
-            if (!no_delete) {
-                retval = get_file_path(
-                    filename.c_str(), download_dir, config.uldl_dir_fanout,
-                    path
-                );
-                if (retval == ERR_OPENDIR) {
-                    log_messages.printf(MSG_CRITICAL,
-                        "[WU#%lu] missing dir for %s\n",
-                        wu.id, filename.c_str()
-                    );
-                    mthd_retval = ERR_UNLINK;
-                } else if (retval) {
-                    log_messages.printf(MSG_CRITICAL,
-                        "[WU#%lu] get_file_path: %s: %s\n",
-                        wu.id, filename.c_str(), boincerror(retval)
-                    );
-                } else {
-                    log_messages.printf(MSG_NORMAL,
-                        "[WU#%lu] deleting %s\n", wu.id, filename.c_str()
-                    );
-                    retval = unlink(path);
-                    if (retval) {
-                        log_messages.printf(MSG_CRITICAL,
-                            "[WU#%lu] unlink %s failed: %s\n",
-                            wu.id, filename.c_str(), boincerror(retval)
-                        );
-                        mthd_retval = ERR_UNLINK;
-                    } else {
-                        count_deleted++;
-                    }
-
-                    // delete the gzipped version of the file
-                    //
-                    sprintf(path_gz, "%s.gz", path);
-                    retval = unlink(path_gz);
-                    if (!retval) {
-                        log_messages.printf(MSG_NORMAL,
-                            "[WU#%lu] deleted %s.gz\n", wu.id, filename.c_str()
-                        );
-                    }
-
-                    // delete the cached MD5 file if needed
-                    //
-                    if (config.cache_md5_info) {
-                        sprintf(path_md5, "%s.md5", path);
-                        log_messages.printf(MSG_NORMAL,
-                            "[WU#%lu] deleting %s.md5\n",
-                            wu.id, filename.c_str()
-                        );
-                        retval = unlink(path_md5);
-                        if (retval) {
-                            log_messages.printf(MSG_CRITICAL,
-                                "[WU#%lu] unlink %s.md5 failed: %s\n",
-                                wu.id, filename.c_str(), boincerror(retval)
-                            );
-                        }
-                    }
-                }
+            log_messages.printf(msg_mode,
+                "[RESULT#%lu] outcome=%d client_state=%d No file %s to delete\n",
+                rec.id, rec.outcome, rec.client_state, fname
+            );
+        } else {
+            log_messages.printf(MSG_NORMAL,
+                "[RESULT#%lu] unlinked %s\n", rec.id, job->path
+            );
+            rec.ndeleted++;
+        }
+    }
+    if (retval) {
+        rec.retval = retval;
+        rec.failed.insert(job->filename);
+    }
+    delete job;
+}
+
+// handle finished jobs; if wait_all, wait for all jobs to finish
+//
+void finish_jobs(vector<DELETE_REC>& recs, bool wait_all) {
+    deque<DELETE_JOB*> jobs;
+    while (1) {
+        pthread_mutex_lock(&queue_mutex);
+        if (wait_all) {
+            while (done_jobs.empty() && njobs_running) {
+                pthread_cond_wait(&job_done, &queue_mutex);
             }
         }
+        jobs.swap(done_jobs);
+        njobs_running -= (int)jobs.size();
+        pthread_mutex_unlock(&queue_mutex);
+        if (jobs.empty()) break;
+        for (unsigned int i=0; i<jobs.size(); i++) {
+            finish_job(jobs[i], recs);
+        }
+        jobs.clear();
     }
-    log_messages.printf(MSG_DEBUG,
-        "[WU#%lu] deleted %d file(s)\n", wu.id, count_deleted
-    );
-    return mthd_retval;
 }
 
-int result_delete_files(RESULT& result) {
-    char pathname[MAXPATHLEN];
-    bool no_delete=false;
-    int count_deleted = 0, retval, mthd_retval = 0;
+void queue_job(DELETE_JOB* job, vector<DELETE_REC>& recs) {
+    if (!nthreads) {
+        do_delete_job(*job);
+        finish_job(job, recs);
+        return;
+    }
+    pthread_mutex_lock(&queue_mutex);
+    while (pending_jobs.size() >= DELETE_QUEUE_SIZE) {
+        pthread_cond_wait(&job_taken, &queue_mutex);
+    }
+    pending_jobs.push_back(job);
+    njobs_running++;
+    pthread_cond_signal(&job_ready);
+    pthread_mutex_unlock(&queue_mutex);
+
+    finish_jobs(recs, false);
+}
 
+// queue the deletion of the files described in a WU's xml_doc
+// or a result's xml_doc_in,
+// skipping those with <no_delete/>.
+// If retry_only is given, delete only those files.
+//
+void queue_files(
+    const char* xml_doc, bool is_wu, vector<DELETE_REC>& recs,
+    set<string>* retry_only
+) {
+    bool no_delete=false;
     MIOFILE mf;
-    mf.init_buf_read(result.xml_doc_in);
+    mf.init_buf_read(xml_doc);
     XML_PARSER xp(&mf);
+
     while (!xp.get_tag()) {
         if (!xp.is_tag) continue;
         if (xp.match_tag("file_info")) {
@@ -258,61 +430,103 @@ int result_delete_files(RESULT& result) {
                 }
             }
             if (!xp.match_tag("/file_info") || filename.empty()) {
-                log_messages.printf(MSG_CRITICAL, "bad result XML: %s\n",
-                    result.xml_doc_in
-                );
-            }
-            if (!no_delete) {
-                retval = get_file_path(
-                    filename.c_str(), config.upload_dir, config.uldl_dir_fanout,
-                    pathname
+                log_messages.printf(MSG_CRITICAL, "bad %s XML: %s\n",
+                    is_wu?"WU":"result", xml_doc
                 );
-                if (retval == ERR_OPENDIR) {
-                    mthd_retval = ERR_OPENDIR;
-                    log_messages.printf(MSG_CRITICAL,
-                        "[RESULT#%lu] missing dir for %s\n",
-                        result.id, pathname
-                    );
-                } else if (retval) {
-                    // the fact that no result files were found is a critical
-                    // error if this was a successful result,
-                    // but is to be expected if the result outcome was failure,
-                    // since in that case no output file may have been produced.
-                    //
-                    int msg_mode;
-                    if (RESULT_OUTCOME_SUCCESS == result.outcome) {
-                        msg_mode = MSG_CRITICAL;
-                    } else {
-                        msg_mode = MSG_DEBUG;
-                    }
-                    log_messages.printf(msg_mode,
-                        "[RESULT#%lu] outcome=%d client_state=%d No file %s to delete\n",
-                        result.id, result.outcome, result.client_state, filename.c_str()
-                    );
-                } else {
-                    retval = unlink(pathname);
-                    if (retval) {
-                        mthd_retval = ERR_UNLINK;
-                        log_messages.printf(MSG_CRITICAL,
-                            "[RESULT#%lu] unlink %s error: %s %s\n",
-                            result.id, pathname, boincerror(retval),
-                            (retval && errno)?strerror(errno):""
-                        );
-                    } else {
-                        count_deleted++;
-                        log_messages.printf(MSG_NORMAL,
-                            "[RESULT#%lu] unlinked %s\n", result.id, pathname
-                        );
-                    }
-                }
             }
+            if (no_delete) continue;
+            if (retry_only && !retry_only->count(filename)) continue;
+            DELETE_JOB* job = new DELETE_JOB;
+            job->irec = (int)recs.size() - 1;
+            job->is_wu = is_wu;
+            job->filename = filename;
+            queue_job(job, recs);
         }
     }
+}
 
-    log_messages.printf(MSG_DEBUG,
-        "[RESULT#%lu] deleted %d file(s)\n", result.id, count_deleted
-    );
-    return mthd_retval;
+// set file_delete_state of the given WUs or results
+//
+int update_file_delete_state(
+    DB_BASE& table, vector<DB_ID_TYPE>& ids, int state
+) {
+    char set_clause[256];
+    string where;
+    char buf[64];
+    int retval;
+
+    if (ids.empty() || no_db_update) return 0;
+    sprintf(set_clause, "file_delete_state=%d", state);
+    for (unsigned int i=0; i<ids.size(); i+=FILE_DELETE_UPDATE_BATCH) {
+        unsigned int n = std::min(ids.size(), (size_t)(i+FILE_DELETE_UPDATE_BATCH));
+        where = "id in (";
+        for (unsigned int j=i; j<n; j++) {
+            sprintf(buf, j>i?",%lu":"%lu", ids[j]);
+            where += buf;
+        }
+        where += ")";
+        retval = table.update_fields_noid(set_clause, where.c_str());
+        if (retval) return retval;
+    }
+    return 0;
+}
+
+// after the files of a batch of WUs or results have been deleted,
+// update their file_delete_state.
+// Return true if we changed any.
+//
+bool finish_records(
+    DB_BASE& table, vector<DELETE_REC>& recs, bool is_wu,
+    map<DB_ID_TYPE, set<string> >& failed_files
+) {
+    vector<DB_ID_TYPE> done_ids, error_ids;
+    const char* kind = is_wu?"WU":"RESULT";
+    bool did_something = false;
+    int retval;
+
+    finish_jobs(recs, true);
+    for (unsigned int i=0; i<recs.size(); i++) {
+        DELETE_REC& rec = recs[i];
+        log_messages.printf(MSG_DEBUG,
+            "[%s#%lu] deleted %d file(s)\n", kind, rec.id, rec.ndeleted
+        );
+        int new_state;
+        if (rec.retval) {
+            new_state = FILE_DELETE_ERROR;
+            log_messages.printf(MSG_CRITICAL,
+                "[%s#%lu] file deletion failed: %s\n",
+                kind, rec.id, boincerror(rec.retval)
+            );
+            failed_files[rec.id] = rec.failed;
+        } else {
+            new_state = FILE_DELETE_DONE;
+            failed_files.erase(rec.id);
+        }
+        if (new_state == rec.file_delete_state) continue;
+        if (new_state == FILE_DELETE_ERROR) {
+            error_ids.push_back(rec.id);
+        } else {
+            done_ids.push_back(rec.id);
+        }
+    }
+
+    retval = update_file_delete_state(table, done_ids, FILE_DELETE_DONE);
+    if (!retval) {
+        retval = update_file_delete_state(table, error_ids, FILE_DELETE_ERROR);
+    }
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "%s file_delete_state update failed: %s\n",
+            kind, boincerror(retval)
+        );
+    } else if (done_ids.size() || error_ids.size()) {
+        log_messages.printf(MSG_DEBUG,
+            "file_delete_state updated for %d %ss\n",
+            (int)(done_ids.size() + error_ids.size()), kind
+        );
+        did_something = true;
+    }
+    return did_something;
 }
 
 // return true if we changed the file_delete_state of a WU or a result
@@ -323,7 +537,10 @@ bool do_pass(bool retry_error) {
     bool did_something = false;
     char buf[256];
     char clause[256];
-    int retval, new_state;
+    int retval;
+    vector<DELETE_REC> recs;
+    DELETE_REC rec;
+    map<DB_ID_TYPE, set<string> >::iterator it;
 
     check_stop_daemons();
 
@@ -352,38 +569,24 @@ bool do_pass(bool retry_error) {
             break;
         }
 
-        if (preserve_result_files) {
-            retval = 0;
-        } else {
-            retval = result_delete_files(result);
-        }
-        if (retval) {
-            new_state = FILE_DELETE_ERROR;
-            log_messages.printf(MSG_CRITICAL,
-                "[RESULT#%lu] file deletion failed: %s\n", result.id, boincerror(retval)
+        rec.id = result.id;
+        rec.file_delete_state = result.file_delete_state;
+        rec.outcome = result.outcome;
+        rec.client_state = result.client_state;
+        rec.ndeleted = 0;
+        rec.retval = 0;
+        recs.push_back(rec);
+        if (!preserve_result_files) {
+            it = result_failed_files.find(result.id);
+            queue_files(result.xml_doc_in, false, recs,
+                (retry_error && it != result_failed_files.end())?&it->second:NULL
             );
-        } else {
-            new_state = FILE_DELETE_DONE;
-        }
-        if (new_state != result.file_delete_state) {
-            sprintf(buf, "file_delete_state=%d", new_state);
-            if (no_db_update) {
-                retval = 0;
-            } else {
-                retval = result.update_field(buf);
-            }
-            if (retval) {
-                log_messages.printf(MSG_CRITICAL,
-                    "[RESULT#%lu] update failed: %s\n", result.id, boincerror(retval)
-                );
-            } else {
-                log_messages.printf(MSG_DEBUG,
-                    "[RESULT#%lu] file_delete_state updated\n", result.id
-                );
-                did_something = true;
-            }
         }
     }
+    if (finish_records(result, recs, false, result_failed_files)) {
+        did_something = true;
+    }
+    recs.clear();
 
     if (xml_doc_like) {
         strcat(clause, " and xml_doc like '");
@@ -406,38 +609,22 @@ bool do_pass(bool retry_error) {
             break;
         }
 
-        if (preserve_wu_files) {
-            retval = 0;
-        } else {
-            retval = wu_delete_files(wu);
-        }
-        if (retval) {
-            new_state = FILE_DELETE_ERROR;
-            log_messages.printf(MSG_CRITICAL,
-                "[WU#%lu] file deletion failed: %s\n", wu.id, boincerror(retval)
+        rec.id = wu.id;
+        rec.file_delete_state = wu.file_delete_state;
+        rec.outcome = rec.client_state = 0;
+        rec.ndeleted = 0;
+        rec.retval = 0;
+        recs.push_back(rec);
+        if (!preserve_wu_files && !strstr(wu.name, "nodelete")) {
+            it = wu_failed_files.find(wu.id);
+            queue_files(wu.xml_doc, true, recs,
+                (retry_error && it != wu_failed_files.end())?&it->second:NULL
             );
-        } else {
-            new_state = FILE_DELETE_DONE;
-        }
-        if (new_state != wu.file_delete_state) {
-            sprintf(buf, "file_delete_state=%d", new_state);
-            if (no_db_update) {
-                retval = 0;
-            } else {
-                retval = wu.update_field(buf);
-            }
-            if (retval) {
-                log_messages.printf(MSG_CRITICAL,
-                    "[WU#%lu] update failed: %s\n", wu.id, boincerror(retval)
-                );
-            } else {
-                log_messages.printf(MSG_DEBUG,
-                    "[WU#%lu] file_delete_state updated\n", wu.id
-                );
-                did_something = true;
-            }
         }
     }
+    if (finish_records(wu, recs, true, wu_failed_files)) {
+        did_something = true;
+    }
 
     return did_something;
 }
@@ -525,6 +712,13 @@ int main(int argc, char** argv) {
             do_output_files = false;
         } else if (is_arg(argv[i], "output_files_only")) {
             do_input_files = false;
+        } else if (is_arg(argv[i], "nthreads")) {
+            if (!argv[++i]) {
+                log_messages.printf(MSG_CRITICAL, "%s requires an argument\n\n", argv[--i]);
+                usage(argv[0]);
+                exit(1);
+            }
+            nthreads = atoi(argv[i]);
         } else if (is_arg(argv[i], "sleep_interval")) {
             if (!argv[++i]) {
                 log_messages.printf(MSG_CRITICAL, "%s requires an argument\n\n", argv[--i]);
@@ -599,6 +793,7 @@ int main(int argc, char** argv) {
     }
 
     install_stop_signal_handler();
+    start_delete_workers();
 
     bool retry_errors_now = !dont_retry_errors;
     double next_error_time=0;
@@ -36,6 +36,8 @@
 #include "crypt.h"
 #include "error_numbers.h"
 #include "filesys.h"
+#include "md5.h"
+#include "md5_file.h"
 #include "parse.h"
 #include "str_replace.h"
 #include "str_util.h"
@@ -108,6 +110,9 @@ int return_success(const char* text) {
 }
 
 #define BLOCK_SIZE  (256*1024)
+#define UPLOAD_BLOCK_SIZE   (4*1024*1024)
+    // copy uploaded data in chunks of this size.
+    // Large chunks mean fewer write() calls for multi-GB files
 double bytes_left=-1;
 
 int accept_empty_file(char* name, char* path) {
@@ -135,13 +140,71 @@ void copy_socket_to_null(FILE* in) {
     }
 }
 
+// start the MD5 of a file being uploaded with the part we already have
+// (i.e. when resuming an upload)
+//
+static int md5_file_prefix(const char* path, double offset, md5_state_t& state) {
+    unsigned char buf[BLOCK_SIZE];
+    double done = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return ERR_FOPEN;
+    while (done < offset) {
+        size_t m = (offset-done)<(double)BLOCK_SIZE ? (size_t)(offset-done) : BLOCK_SIZE;
+        ssize_t n = read(fd, buf, m);
+        if (n <= 0) {
+            close(fd);
+            return ERR_READ;
+        }
+        md5_append(&state, buf, (int)n);
+        done += n;
+    }
+    close(fd);
+    return 0;
+}
+
+// write FILENAME.md5 containing MD5 and size,
+// in the format used for input files (see process_input_template.cpp)
+//
+static void write_md5_info(const char* md5_path, md5_state_t& state, double nbytes) {
+    unsigned char binout[16];
+    char md5[MD5_LEN];
+    md5_finish(&state, binout);
+    for (int i=0; i<16; i++) {
+        sprintf(md5+2*i, "%02x", binout[i]);
+    }
+    md5[32] = 0;
+    FILE* f = boinc::fopen(md5_path, "w");
+    if (!f) {
+        log_messages.printf(MSG_CRITICAL,
+            "can't create %s: %s\n", md5_path, strerror(errno)
+        );
+        return;
+    }
+    int retval = boinc::fprintf(f, "%s %.15e\n", md5, nbytes);
+    if (boinc::fclose(f) || retval < 0) {
+        unlink(md5_path);
+    }
+}
+
 // read from socket, write to file
 // ALWAYS returns an HTML reply
 //
 int copy_socket_to_file(FILE* in, char* name, char* path, double offset, double nbytes) {
-    unsigned char buf[BLOCK_SIZE];
+    static unsigned char* buf = NULL;
+        // allocated once; too big for the stack,
+        // and the FCGI version handles many requests
     struct stat sbuf;
     int pid, fd=0;
+    char md5_path[MAXPATHLEN];
+    md5_state_t md5_state;
+    bool do_md5 = false;
+
+    if (!buf) {
+        buf = (unsigned char*)malloc(UPLOAD_BLOCK_SIZE);
+        if (!buf) {
+            return return_error(ERR_TRANSIENT, "can't allocate buffer");
+        }
+    }
 
     // caller guarantees that nbytes > offset
     //
@@ -150,7 +213,7 @@ int copy_socket_to_file(FILE* in, char* name, char* path, double offset, double
     while (bytes_left > 0) {
         size_t m;
 
-        m = bytes_left<(double)BLOCK_SIZE ? (size_t)bytes_left : BLOCK_SIZE;
+        m = bytes_left<(double)UPLOAD_BLOCK_SIZE ? (size_t)bytes_left : UPLOAD_BLOCK_SIZE;
 
         // try to get m bytes from socket (n>=0 is number actually returned)
         //
@@ -206,10 +269,10 @@ int copy_socket_to_file(FILE* in, char* name, char* path, double offset, double
             }
 #endif
 
-            // check that file length corresponds to offset
-            // TODO: use a 64-bit variant
+            // check that file length corresponds to offset.
+            // off_t is 64 bits (configure uses AC_SYS_LARGEFILE)
             //
-            if (stat(path, &sbuf)) {
+            if (fstat(fd, &sbuf)) {
                 close(fd);
                 return return_error(ERR_TRANSIENT,
                     "can't stat file %s: %s\n", name, strerror(errno)
@@ -218,12 +281,12 @@ int copy_socket_to_file(FILE* in, char* name, char* path, double offset, double
             if (sbuf.st_size < offset) {
                 close(fd);
                 return return_error(ERR_TRANSIENT,
-                    "length of file %s %zu bytes < offset %.0f bytes",
-                    name, sbuf.st_size, offset
+                    "length of file %s %.0f bytes < offset %.0f bytes",
+                    name, (double)sbuf.st_size, offset
                 );
             }
             if (offset) {
-                if (-1 == lseek(fd, offset, SEEK_SET)) {
+                if (-1 == lseek(fd, (off_t)offset, SEEK_SET)) {
                     int err = errno; // make a copy to report the lseek() error and not printf() or close() errors.
                     log_messages.printf(MSG_CRITICAL,
                         "lseek(%s, %.0f) failed: %s (%d).\n",
@@ -237,10 +300,28 @@ int copy_socket_to_file(FILE* in, char* name, char* path, double offset, double
             }
             if (sbuf.st_size > offset) {
                 log_messages.printf(MSG_NORMAL,
-                    "file %s length on disk %zu bytes; host upload starting at %.0f bytes.\n",
-                     this_filename, sbuf.st_size, offset
+                    "file %s length on disk %.0f bytes; host upload starting at %.0f bytes.\n",
+                     this_filename, (double)sbuf.st_size, offset
                 );
             }
+
+            // compute the MD5 as data arrives,
+            // so that the validator doesn't have to read the file again.
+            // Remove any .md5 file from a previous upload.
+            //
+            if (config.fuh_md5_info) {
+                snprintf(md5_path, sizeof(md5_path), "%s.md5", path);
+                unlink(md5_path);
+                md5_init(&md5_state);
+                do_md5 = true;
+                if (offset && md5_file_prefix(path, offset, md5_state)) {
+                    log_messages.printf(MSG_NORMAL,
+                        "can't read first %.0f bytes of %s; not computing MD5\n",
+                        offset, this_filename
+                    );
+                    do_md5 = false;
+                }
+            }
         }
 
         // try to write n bytes to file
@@ -262,6 +343,9 @@ int copy_socket_to_file(FILE* in, char* name, char* path, double offset, double
             }
             to_write -= ret;
         }
+        if (do_md5) {
+            md5_append(&md5_state, buf, (int)n);
+        }
 
         // check that we got all bytes from socket that were requested
         // Note: fread() reads less than requested only if there's
@@ -300,6 +384,9 @@ int copy_socket_to_file(FILE* in, char* name, char* path, double offset, double
         }
     }
     close(fd);
+    if (do_md5) {
+        write_md5_info(md5_path, md5_state, nbytes);
+    }
     return return_success(0);
 }
 
@@ -481,7 +568,6 @@ int handle_get_file_size(char* file_name) {
     int retval, pid, fd;
 
     // TODO: check to ensure path doesn't point somewhere bad
-    // Use 64-bit variant
     //
     retval = dir_hier_path(
         file_name, config.upload_dir, config.uldl_dir_fanout, path
@@ -548,11 +634,14 @@ int handle_get_file_size(char* file_name) {
         return return_error(ERR_TRANSIENT, "cannot stat file" );
     }
 
+    // the client parses this as a double,
+    // so files > 2GB can be resumed
+    //
     log_messages.printf(MSG_NORMAL,
-        "handle_get_file_size(): [%s] returning %d\n",
-        file_name, (int)sbuf.st_size
+        "handle_get_file_size(): [%s] returning %.0f\n",
+        file_name, (double)sbuf.st_size
     );
-    sprintf(buf, "<file_size>%d</file_size>", (int)sbuf.st_size);
+    sprintf(buf, "<file_size>%.0f</file_size>", (double)sbuf.st_size);
     return return_success(buf);
 }
 
@@ -49,6 +49,7 @@ using std::string;
 
 #include "credit.h"
 #include "handle_request.h"
+#include "host_update_log.h"
 #include "sched_config.h"
 #include "sched_customize.h"
 #include "sched_files.h"
@@ -293,19 +294,24 @@ int authenticate_user() {
     DB_HOST host;
     DB_USER user;
     DB_TEAM team;
+    DB_HOST_USER_TEAM hut;
+    bool have_team = false;
 
     if (g_request->hostid) {
-        retval = host.lookup_id(g_request->hostid);
-        while (!retval && host.userid==0) {
+        // get the host, its user and their team in one query;
+        // in the usual case that's all we need
+        //
+        retval = hut.lookup(g_request->hostid);
+        while (!retval && hut.host.userid==0) {
             // if host record is zombie, follow link to new host
             // TODO: check for infinite loop
             //
-            retval = host.lookup_id(host.rpc_seqno);
+            retval = hut.lookup(hut.host.rpc_seqno);
             if (!retval) {
-                g_reply->hostid = host.id;
+                g_reply->hostid = hut.host.id;
                 log_messages.printf(MSG_NORMAL,
                     "[HOST#%lu] forwarding to new host ID %lu\n",
-                    g_request->hostid, host.id
+                    g_request->hostid, hut.host.id
                 );
             }
         }
@@ -322,15 +328,24 @@ int authenticate_user() {
             goto lookup_user_and_make_new_host;
         }
 
+        host = hut.host;
         g_reply->host = host;
 
-        // We have a host record based on ID.
-        // Look up user based on host.userid,
-        // and see if the authenticator matches request (regular or weak)
+        // We have a host record based on ID,
+        // and the user based on host.userid.
+        // See if the authenticator matches request (regular or weak)
         //
         g_request->using_weak_auth = false;
-        sprintf(buf, "where id=%lu", host.userid);
-        retval = user.lookup(buf);
+        if (hut.have_user) {
+            user = hut.user;
+            if (hut.have_team) {
+                team = hut.team;
+                have_team = true;
+            }
+            retval = 0;
+        } else {
+            retval = ERR_DB_NOT_FOUND;
+        }
         if (!retval && !strcmp(user.authenticator, g_request->authenticator)) {
             // req auth matches user auth - go on
         } else {
@@ -549,8 +564,15 @@ got_host:
     //
 
     if (g_reply->user.teamid) {
-        retval = team.lookup_id(g_reply->user.teamid);
-        if (!retval) g_reply->team = team;
+        // we may already have the team from the host lookup;
+        // if the user changed (e.g. authenticator lookup) look it up
+        //
+        if (have_team && team.id == g_reply->user.teamid) {
+            g_reply->team = team;
+        } else {
+            retval = team.lookup_id(g_reply->user.teamid);
+            if (!retval) g_reply->team = team;
+        }
     }
 
     // compute email hash
@@ -671,6 +693,20 @@ static int update_host_record(HOST& initial_host, HOST& xhost, USER& user) {
     if (p) {
         strlcpy(host.external_ip_addr, p, sizeof(host.external_ip_addr));
     }
+    if (config.defer_host_updates) {
+        char updates[BLOB_SIZE];
+        host.get_diff_sched(initial_host, updates);
+        if (!strlen(updates)) return 0;
+        retval = write_host_update(
+            config.project_path(HOST_UPDATE_LOG_FILE),
+            host, initial_host, updates
+        );
+        if (!retval) return 0;
+        log_messages.printf(MSG_CRITICAL,
+            "can't write host update log: %s; updating DB\n",
+            boincerror(retval)
+        );
+    }
     retval = host.update_diff_sched(initial_host);
     if (retval) {
         log_messages.printf(MSG_CRITICAL,
@@ -1250,12 +1286,10 @@ void process_request(char* code_sign_key) {
         if (config.locality_scheduling || config.locality_scheduler_fraction || config.enable_assignment) {
             have_no_work = false;
         } else {
-            lock_sema();
             have_no_work = ssp->no_work(g_pid);
             if (have_no_work) {
                 g_wreq->no_jobs_available = true;
             }
-            unlock_sema();
         }
     }
 
@@ -0,0 +1,261 @@
+// This file is part of BOINC.
+// https://boinc.berkeley.edu
+// Copyright (C) 2026 University of California
+//
+// BOINC is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+// BOINC is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with BOINC.  If not, see <http://www.gnu.org/licenses/>.
+
+// See host_update_log.h
+
+#include "config.h"
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "boinc_db_types.h"
+#include "error_numbers.h"
+
+#include "host_update_log.h"
+
+using std::string;
+
+// counters that the scheduler increments;
+// these are logged as increments (see host_update_log.h)
+//
+static const struct {
+    const char* name;
+    int HOST::*field;
+} counter_fields[] = {
+    {"nresults_today", &HOST::nresults_today},
+    {"nsame_ip_addr", &HOST::nsame_ip_addr},
+};
+
+// if value is an increment "name+N", return true and set n
+//
+static bool parse_increment(const string& name, const string& value, int& n) {
+    if (value.compare(0, name.size(), name)) return false;
+    if (value[name.size()] != '+') return false;
+    n = atoi(value.c_str() + name.size() + 1);
+    return true;
+}
+
+static string increment_str(const string& name, int n) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s+%d", name.c_str(), n);
+    return buf;
+}
+
+static void format_record(DB_ID_TYPE hostid, const string& clause, string& rec) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%lu %d\n", hostid, (int)clause.size());
+    rec = buf;
+    rec += clause;
+    rec += "\n";
+}
+
+// the daemon renames the log before reading it,
+// so try a few times if we opened the old file
+//
+#define WRITE_TRIES 10
+
+int write_host_update(
+    const char* path, HOST& host, HOST& initial_host, const char* updates
+) {
+    HOST_UPDATE_FIELDS fields;
+    string clause, rec;
+    struct stat sb1, sb2;
+    int retval;
+
+    retval = parse_host_update_clause(updates, fields);
+    if (retval) return retval;
+
+    // a counter set to zero has been reset; log that as is
+    //
+    for (unsigned int i=0; i<sizeof(counter_fields)/sizeof(counter_fields[0]); i++) {
+        HOST_UPDATE_FIELDS::iterator j = fields.find(counter_fields[i].name);
+        if (j == fields.end()) continue;
+        int n = host.*counter_fields[i].field;
+        if (n == 0) continue;
+        j->second = increment_str(
+            j->first, n - initial_host.*counter_fields[i].field
+        );
+    }
+    host_update_clause(fields, clause);
+    format_record(host.id, clause, rec);
+
+    for (int i=0; i<WRITE_TRIES; i++) {
+        int fd = open(path, O_WRONLY|O_APPEND|O_CREAT, 0664);
+        if (fd < 0) return ERR_FOPEN;
+        if (flock(fd, LOCK_EX)) {
+            close(fd);
+            return ERR_FOPEN;
+        }
+
+        // if the file was renamed since we opened it, reopen
+        //
+        if (fstat(fd, &sb1) || stat(path, &sb2)
+            || sb1.st_ino != sb2.st_ino || sb1.st_dev != sb2.st_dev
+        ) {
+            close(fd);
+            continue;
+        }
+        ssize_t n = write(fd, rec.c_str(), rec.size());
+        close(fd);
+        if (n != (ssize_t)rec.size()) return ERR_WRITE;
+        return 0;
+    }
+    return ERR_FOPEN;
+}
+
+// parse a clause as written by DB_HOST::get_diff_sched():
+// " name=value, name='string', ..."
+// where strings are escaped with backslashes.
+//
+int parse_host_update_clause(const char* p, HOST_UPDATE_FIELDS& fields) {
+    while (1) {
+        while (*p == ' ' || *p == ',') p++;
+        if (!*p) return 0;
+        const char* q = strchr(p, '=');
+        if (!q || q == p) return ERR_BAD_FORMAT;
+        string name(p, q-p);
+        p = q+1;
+        q = p;
+        if (*q == '\'') {
+            q++;
+            while (*q && *q != '\'') {
+                if (*q == '\\' && q[1]) q++;
+                q++;
+            }
+            if (*q != '\'') return ERR_BAD_FORMAT;
+            q++;
+        } else {
+            while (*q && *q != ',') q++;
+        }
+        if (q == p) return ERR_BAD_FORMAT;
+        fields[name] = string(p, q-p);
+        p = q;
+    }
+}
+
+void host_update_clause(HOST_UPDATE_FIELDS& fields, string& clause) {
+    HOST_UPDATE_FIELDS::iterator i;
+    clause.clear();
+    for (i = fields.begin(); i != fields.end(); ++i) {
+        if (!clause.empty()) clause += ", ";
+        clause += i->first;
+        clause += "=";
+        clause += i->second;
+    }
+}
+
+// merge a field into a host's updates.
+// Increments are added to the earlier value of the field, if any.
+//
+static void merge_field(
+    HOST_UPDATE_FIELDS& hf, const string& name, const string& value
+) {
+    int n, m;
+    HOST_UPDATE_FIELDS::iterator i = hf.find(name);
+    if (i == hf.end() || !parse_increment(name, value, n)) {
+        hf[name] = value;
+        return;
+    }
+    if (parse_increment(name, i->second, m)) {
+        i->second = increment_str(name, m+n);
+    } else {
+        i->second = std::to_string(atoi(i->second.c_str()) + n);
+    }
+}
+
+// parse the record starting at buf[pos] and merge it into the map.
+// If it's OK, return true and set next to the position after it.
+//
+static bool parse_record(
+    const string& buf, size_t pos, HOST_UPDATES& updates, size_t& next
+) {
+    unsigned long hostid;
+    int len, n;
+
+    if (!isdigit(buf[pos])) return false;
+    if (sscanf(buf.c_str()+pos, "%lu %d%n", &hostid, &len, &n) != 2) {
+        return false;
+    }
+    if (len <= 0 || len > BLOB_SIZE) return false;
+    pos += n;
+    if (pos + len + 2 > buf.size()) return false;
+    if (buf[pos] != '\n' || buf[pos+1+len] != '\n') return false;
+
+    // parse into a temporary, so that a bad record has no effect
+    //
+    HOST_UPDATE_FIELDS fields;
+    if (parse_host_update_clause(buf.substr(pos+1, len).c_str(), fields)) {
+        return false;
+    }
+    HOST_UPDATE_FIELDS& hf = updates[hostid];
+    HOST_UPDATE_FIELDS::iterator i;
+    for (i = fields.begin(); i != fields.end(); ++i) {
+        merge_field(hf, i->first, i->second);
+    }
+    next = pos + len + 2;
+    return true;
+}
+
+int read_host_updates(FILE* f, HOST_UPDATES& updates, int& nrecords, int& nbad) {
+    char tmp[65536];
+    string buf;
+    size_t n, pos = 0, next;
+    bool skipping = false;
+
+    while ((n = fread(tmp, 1, sizeof(tmp), f)) > 0) {
+        buf.append(tmp, n);
+    }
+    if (ferror(f)) return ERR_READ;
+
+    nrecords = 0;
+    nbad = 0;
+    while (pos < buf.size()) {
+        if (parse_record(buf, pos, updates, next)) {
+            nrecords++;
+            skipping = false;
+            pos = next;
+            continue;
+        }
+
+        // bad record (e.g. a partial write).
+        // The next record may start anywhere after it,
+        // even in the middle of a line, so look at each position.
+        //
+        if (!skipping) nbad++;
+        skipping = true;
+        pos++;
+    }
+    return 0;
+}
+
+int write_host_updates(FILE* f, HOST_UPDATES& updates) {
+    string clause, rec;
+    HOST_UPDATES::iterator i;
+    for (i = updates.begin(); i != updates.end(); ++i) {
+        host_update_clause(i->second, clause);
+        if (clause.empty()) continue;
+        format_record(i->first, clause, rec);
+        if (fwrite(rec.c_str(), 1, rec.size(), f) != rec.size()) {
+            return ERR_FWRITE;
+        }
+    }
+    return 0;
+}
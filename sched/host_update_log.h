@@ -0,0 +1,71 @@
+// This file is part of BOINC.
+// https://boinc.berkeley.edu
+// Copyright (C) 2026 University of California
+//
+// BOINC is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+// BOINC is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with BOINC.  If not, see <http://www.gnu.org/licenses/>.
+
+// Deferred host record updates.
+//
+// If <defer_host_updates> is set in config.xml,
+// the scheduler appends the "set" clause of each host update
+// to a log file in the project directory instead of updating the DB.
+// The host_updater daemon periodically takes the log,
+// merges the updates for each host
+// (later values of a field replace earlier ones)
+// and applies them in batches.
+//
+// The scheduler's copy of the host record doesn't include
+// updates still in the log.
+// That's OK for fields copied from the request,
+// but counters that the scheduler increments (e.g. nsame_ip_addr)
+// are logged as increments ("nsame_ip_addr=nsame_ip_addr+1"),
+// which are added up when merging;
+// otherwise the increments of other RPCs in the interval would be lost.
+//
+// Each record is "<hostid> <length>\n<clause>\n".
+// Writers lock the file with flock() while appending.
+
+#ifndef BOINC_HOST_UPDATE_LOG_H
+#define BOINC_HOST_UPDATE_LOG_H
+
+#include <cstdio>
+#include <map>
+#include <string>
+
+#include "boinc_db_types.h"
+
+#define HOST_UPDATE_LOG_FILE    "host_update_log"
+
+// field name -> SQL value (e.g. "123" or "'abc'")
+//
+typedef std::map<std::string, std::string> HOST_UPDATE_FIELDS;
+typedef std::map<DB_ID_TYPE, HOST_UPDATE_FIELDS> HOST_UPDATES;
+
+extern int write_host_update(
+    const char* path, HOST& host, HOST& initial_host, const char* clause
+);
+    // clause is from host.get_diff_sched(initial_host)
+
+extern int parse_host_update_clause(const char* clause, HOST_UPDATE_FIELDS&);
+extern void host_update_clause(HOST_UPDATE_FIELDS&, std::string&);
+
+extern int read_host_updates(FILE*, HOST_UPDATES&, int& nrecords, int& nbad);
+    // read records, merging them into the map.
+    // A malformed record (e.g. from a failed write) is skipped;
+    // nbad is the number of these.
+
+extern int write_host_updates(FILE*, HOST_UPDATES&);
+    // write the map as records, e.g. to keep the ones not yet applied
+
+#endif
@@ -0,0 +1,271 @@
+// This file is part of BOINC.
+// https://boinc.berkeley.edu
+// Copyright (C) 2026 University of California
+//
+// BOINC is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+// BOINC is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with BOINC.  If not, see <http://www.gnu.org/licenses/>.
+
+// host_updater - apply host record updates logged by the scheduler
+// when <defer_host_updates> is set (see host_update_log.h).
+//
+//  [--sleep_interval N]    seconds between passes (default 5).
+//                          Longer intervals merge more updates per host,
+//                          but the host records seen by the scheduler
+//                          (e.g. nresults_today) lag further behind.
+//  [--batch_size N]        host updates per transaction (default 100)
+//  [--one_pass]            do one pass, then exit
+//  [-d N]                  set debug level
+//
+// Each pass renames the log to host_update_log.work,
+// merges its records so there's one update per host,
+// applies them, and deletes the file.
+// If the DB updates fail, the file is rewritten with the updates
+// that weren't committed, and retried next pass.
+// (Increments in committed updates must not be applied twice.)
+
+#include "config.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <sys/file.h>
+
+#include "boinc_db.h"
+#include "error_numbers.h"
+#include "filesys.h"
+#include "str_replace.h"
+#include "str_util.h"
+#include "svn_version.h"
+#include "util.h"
+
+#include "host_update_log.h"
+#include "sched_config.h"
+#include "sched_msgs.h"
+#include "sched_util.h"
+
+using std::string;
+
+int sleep_interval = 5;
+int batch_size = 100;
+
+// apply the updates, in transactions of batch_size hosts.
+// Committed updates are removed from the map.
+//
+int apply_updates(HOST_UPDATES& updates) {
+    string clause, query;
+    char buf[256];
+    int retval;
+
+    while (!updates.empty()) {
+        retval = boinc_db.start_transaction();
+        if (retval) return retval;
+        HOST_UPDATES::iterator i = updates.begin();
+        for (int n=0; n<batch_size && i != updates.end(); n++, ++i) {
+            host_update_clause(i->second, clause);
+            if (clause.empty()) continue;
+            snprintf(buf, sizeof(buf), " where id=%lu", i->first);
+            query = "update host set " + clause + buf;
+            retval = boinc_db.do_query(query.c_str());
+            if (retval) {
+                log_messages.printf(MSG_CRITICAL,
+                    "[HOST#%lu] update failed: %s\n",
+                    i->first, boinc_db.error_string()
+                );
+                boinc_db.rollback_transaction();
+                return retval;
+            }
+        }
+        retval = boinc_db.commit_transaction();
+        if (retval) return retval;
+        updates.erase(updates.begin(), i);
+    }
+    return 0;
+}
+
+// replace the file with the given updates
+//
+int rewrite_file(const char* path, HOST_UPDATES& updates) {
+    char tmp_path[MAXPATHLEN];
+    int retval;
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE* f = boinc::fopen(tmp_path, "w");
+    if (!f) return ERR_FOPEN;
+    retval = write_host_updates(f, updates);
+    if (boinc::fclose(f)) retval = ERR_FWRITE;
+    if (!retval) retval = boinc_rename(tmp_path, path);
+    return retval;
+}
+
+// apply the updates in the given file, and delete it
+//
+int do_file(const char* path) {
+    HOST_UPDATES updates;
+    int retval, nrecords, nbad;
+
+    FILE* f = boinc::fopen(path, "r");
+    if (!f) return ERR_FOPEN;
+
+    // wait for a scheduler that opened the file before it was renamed
+    //
+    flock(fileno(f), LOCK_EX);
+
+    retval = read_host_updates(f, updates, nrecords, nbad);
+    boinc::fclose(f);
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "%s: read failed: %s; will retry\n", path, boincerror(retval)
+        );
+        return retval;
+    }
+    if (nbad) {
+        log_messages.printf(MSG_CRITICAL,
+            "%s: skipped %d bad records\n", path, nbad
+        );
+    }
+    int nhosts = (int)updates.size();
+    retval = apply_updates(updates);
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "DB update failed: %s; will retry %d hosts\n",
+            boincerror(retval), (int)updates.size()
+        );
+        if (rewrite_file(path, updates)) {
+            log_messages.printf(MSG_CRITICAL, "can't rewrite %s\n", path);
+        }
+        return retval;
+    }
+    log_messages.printf(MSG_NORMAL,
+        "applied %d updates to %d hosts\n", nrecords, nhosts
+    );
+    boinc_delete_file(path);
+    return 0;
+}
+
+// returns true if there was anything to do
+//
+bool do_pass() {
+    char log_path[MAXPATHLEN], work_path[MAXPATHLEN];
+    int retval;
+
+    strlcpy(log_path, config.project_path(HOST_UPDATE_LOG_FILE), sizeof(log_path));
+    snprintf(work_path, sizeof(work_path), "%s.work", log_path);
+
+    // finish a file left over from a failed or interrupted pass
+    //
+    if (boinc_file_exists(work_path)) {
+        retval = do_file(work_path);
+        if (retval) return true;
+    }
+
+    if (!boinc_file_exists(log_path)) return false;
+    if (rename(log_path, work_path)) {
+        log_messages.printf(MSG_CRITICAL,
+            "can't rename %s to %s\n", log_path, work_path
+        );
+        return false;
+    }
+    do_file(work_path);
+    return true;
+}
+
+void usage(char *name) {
+    fprintf(stderr,
+        "Apply host record updates logged by the scheduler.\n\n"
+        "Usage: %s [OPTION]...\n\n"
+        "Options:\n"
+        "  [ --sleep_interval N ]          seconds between passes (default 5)\n"
+        "  [ --batch_size N ]              host updates per transaction (default 100)\n"
+        "  [ --one_pass ]                  do one pass, then exit\n"
+        "  [ -d X ]                        Set debug level to X\n"
+        "  [ -h --help ]                   show this help text.\n"
+        "  [ -v | --version ]              show version information\n",
+        name
+    );
+}
+
+int main(int argc, char** argv) {
+    int i, retval;
+    bool one_pass = false;
+
+    check_stop_daemons();
+
+    for (i=1; i<argc; i++) {
+        if (is_arg(argv[i], "one_pass")) {
+            one_pass = true;
+        } else if (is_arg(argv[i], "sleep_interval")) {
+            if (!argv[++i]) {
+                usage(argv[0]);
+                exit(1);
+            }
+            sleep_interval = atoi(argv[i]);
+        } else if (is_arg(argv[i], "batch_size")) {
+            if (!argv[++i]) {
+                usage(argv[0]);
+                exit(1);
+            }
+            batch_size = atoi(argv[i]);
+            if (batch_size < 1) batch_size = 1;
+        } else if (is_arg(argv[i], "d")) {
+            if (!argv[++i]) {
+                log_messages.printf(MSG_CRITICAL, "%s requires an argument\n\n", argv[--i]);
+                usage(argv[0]);
+                exit(1);
+            }
+            int dl = atoi(argv[i]);
+            log_messages.set_debug_level(dl);
+            if (dl == 4) g_print_queries = true;
+        } else if (is_arg(argv[i], "h") || is_arg(argv[i], "help")) {
+            usage(argv[0]);
+            exit(0);
+        } else if (is_arg(argv[i], "v") || is_arg(argv[i], "version")) {
+            printf("%s\n", SVN_VERSION);
+            exit(0);
+        } else {
+            log_messages.printf(MSG_CRITICAL, "unknown command line argument: %s\n\n", argv[i]);
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+
+    retval = config.parse_file();
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "Can't parse config.xml: %s\n", boincerror(retval)
+        );
+        exit(1);
+    }
+
+    retval = boinc_db.open(
+        config.db_name, config.db_host, config.db_user, config.db_passwd
+    );
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "boinc_db.open failed: %s\n", boinc_db.error_string()
+        );
+        exit(1);
+    }
+
+    log_messages.printf(MSG_NORMAL, "Starting host updater\n");
+
+    install_stop_signal_handler();
+
+    // coverity[loop_top] - infinite loop is intended
+    while (1) {
+        check_stop_daemons();
+        do_pass();
+        if (one_pass) break;
+        daemon_sleep(sleep_interval);
+    }
+}
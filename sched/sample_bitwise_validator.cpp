@@ -92,7 +92,11 @@ int init_result(const RESULT& result, void*& data) {
 
     for (const OUTPUT_FILE_INFO& fi: files) {
         if (fi.no_validate) continue;
-        retval = md5_file(fi.path.c_str(), md5_buf, nbytes, is_gzip);
+        if (is_gzip) {
+            retval = md5_file(fi.path.c_str(), md5_buf, nbytes, is_gzip);
+        } else {
+            retval = get_output_file_md5(fi.path.c_str(), md5_buf, nbytes);
+        }
         if (retval) {
             if (fi.optional && retval == ERR_FOPEN) {
                 strcpy(md5_buf, "");
@@ -43,8 +43,11 @@
 //
 static bool quick_check(
     WU_RESULT& wu_result,
-    WORKUNIT& wu,       // a mutable copy of wu_result.workunit.
-        // We may modify its delay_bound, rsc_fpops_est, and rsc_fpops_bound
+    WORKUNIT& wu,       // if we get as far as wu_is_infeasible_fast(),
+        // set to a mutable copy of wu_result.workunit.
+        // We may modify its delay_bound, rsc_fpops_est, and rsc_fpops_bound.
+        // WORKUNIT is large, so we copy it only for jobs
+        // that pass the cheaper checks.
     BEST_APP_VERSION* &bavp,
     APP* app,
     int& last_retval
@@ -143,7 +146,7 @@ static bool quick_check(
 
     // Find the best app_version for this host.
     //
-    bavp = get_app_version(wu, true, g_wreq->reliable_only);
+    bavp = get_app_version(wu_result.workunit, true, g_wreq->reliable_only);
     if (!bavp) {
         if (config.debug_send_job) {
             log_messages.printf(MSG_NORMAL,
@@ -165,7 +168,7 @@ static bool quick_check(
             if (config.debug_send_job) {
                 log_messages.printf(MSG_NORMAL,
                     "[send_job] [USER#%lu] [WU#%lu] user doesn't want work for app %s\n",
-                    g_reply->user.id, wu.id, app->name
+                    g_reply->user.id, wu_result.workunit.id, app->name
                 );
             }
             return false;
@@ -175,6 +178,7 @@ static bool quick_check(
     // Check whether we can send this job.
     // This may modify wu.delay_bound and wu.rsc_fpops_est
     //
+    wu = wu_result.workunit;
     retval = wu_is_infeasible_fast(
         wu,
         wu_result.res_server_state, wu_result.res_priority,
@@ -218,23 +222,24 @@ static bool quick_check(
 //
 static bool scan_work_array() {
     int i, j, rnd_off, last_retval=0;;
+    WORKUNIT wu;
     APP* app;
     BEST_APP_VERSION* bavp;
     bool no_more_needed = false;
     SCHED_DB_RESULT result;
 
-    // To minimize the amount of time we lock the array,
-    // we initially scan without holding the lock.
-    // If we find a job that passes quick_check(),
-    // we acquire the lock and then check the job again.
+    // We initially check each job without reserving it.
+    // If it passes quick_check(), we reserve it
+    // (atomically changing its state from PRESENT to our PID)
+    // and then check it again,
+    // since the feeder may have replaced it in the meantime.
     //
-    bool sema_locked = false;
-
     rnd_off = rand() % ssp->max_wu_results;
     for (j=0; j<ssp->max_wu_results; j++) {
         i = (j+rnd_off) % ssp->max_wu_results;
 
         WU_RESULT& wu_result = ssp->wu_results[i];
+        bool reserved = false;
 
         if (config.debug_send_job) {
             log_messages.printf(MSG_NORMAL,
@@ -247,23 +252,24 @@ recheck:
             continue;
         }
 
-        // make a copy of the WORKUNIT part,
-        // which we can modify without affecting the cache
-        //
-        WORKUNIT wu = wu_result.workunit;
-
         app = ssp->lookup_app(wu_result.workunit.appid);
         if (app == NULL) {
             log_messages.printf(MSG_CRITICAL,
                 "[WU#%lu] no app\n",
                 wu_result.workunit.id
             );
+            if (reserved) wu_result.state = WR_STATE_PRESENT;
             continue; // this should never happen
         }
 
-        if (app->non_cpu_intensive) continue;
+        if (app->non_cpu_intensive) {
+            if (reserved) wu_result.state = WR_STATE_PRESENT;
+            continue;
+        }
 
         // do fast (non-DB) checks.
+        // If they pass, wu is a copy of the WORKUNIT part,
+        // which we can modify without affecting the cache.
         // This may modify wu.rsc_fpops_est
         //
         if (!quick_check(wu_result, wu, bavp, app, last_retval)) {
@@ -272,26 +278,26 @@ recheck:
                     "[send_job] slot %d failed quick check\n", i
                 );
             }
+            if (reserved) wu_result.state = WR_STATE_PRESENT;
             continue;
         }
 
-        if (!sema_locked) {
-            lock_sema();
-            sema_locked = true;
-            goto recheck;
-        }
-
-        // mark wu_result as checked out and release semaphore.
+        // mark wu_result as checked out.
+        // If it's already ours (from no_work()) there's nothing to do.
         // from here on in this loop, don't continue on failure;
-        // instead, goto dont_send (so that we reacquire semaphore)
+        // instead, reset the state of the slot.
         //
-        // Note: without the semaphore we don't have mutual exclusion;
+        // Note: we don't have mutual exclusion with the DB;
         // ideally we should use a transaction from now until when
         // we commit to sending the results.
-
-        wu_result.state = g_pid;
-        unlock_sema();
-        sema_locked = false;
+        //
+        if (!reserved && wu_result.state != g_pid) {
+            if (!wu_result.change_state(WR_STATE_PRESENT, g_pid)) {
+                continue;
+            }
+            reserved = true;
+            goto recheck;
+        }
 
         switch (slow_check(wu_result, app, bavp)) {
         case 1:
@@ -348,9 +354,6 @@ recheck:
             break;
         }
     }
-    if (sema_locked) {
-        unlock_sema();
-    }
     return no_more_needed;
 }
 
@@ -157,6 +157,7 @@ int SCHED_CONFIG::parse(FILE* f) {
         if (xp.parse_int("uldl_dir_fanout", uldl_dir_fanout)) continue;
         if (xp.parse_bool("cache_md5_info", cache_md5_info)) continue;
         if (xp.parse_int("fuh_debug_level", fuh_debug_level)) continue;
+        if (xp.parse_bool("fuh_md5_info", fuh_md5_info)) continue;
         if (xp.parse_str("fuh_set_completed_permission", buf, sizeof(buf))) {
             long int l = strtol(buf, NULL, 8);
             if (l > 0 && l < LONG_MAX) {
@@ -326,6 +327,8 @@ int SCHED_CONFIG::parse(FILE* f) {
         if (xp.parse_bool("rte_no_stats", rte_no_stats)) continue;
         if (xp.parse_bool("batch_accel", batch_accel)) continue;
         if (xp.parse_bool("size_classes", size_classes)) continue;
+        if (xp.parse_bool("defer_host_updates", defer_host_updates)) continue;
+        if (xp.parse_bool("wu_queue", wu_queue)) continue;
 
         //////////// SCHEDULER LOG FLAGS /////////
 
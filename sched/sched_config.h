@@ -78,6 +78,9 @@ struct SCHED_CONFIG {
     int fuh_debug_level;
     int fuh_set_completed_permission;
     int fuh_set_initial_permission;
+    bool fuh_md5_info;
+        // file upload handler computes the MD5 of uploaded files
+        // as they arrive, and writes it to FILENAME.md5
     int reliable_priority_on_over;
         // additional results generated after at least one result
         // is over will have their priority boosted by this amount
@@ -193,6 +196,13 @@ struct SCHED_CONFIG {
         // send high-prio jobs only to low-turnaround hosts
     bool size_classes;
         // use size classes
+    bool defer_host_updates;
+        // append host record updates to a log file
+        // rather than doing them directly;
+        // the host_updater daemon applies them
+    bool wu_queue;
+        // when a WU needs a transition, add it to the wu_queue table
+        // so that the transitioner doesn't have to wait for its next scan
 
     // time intervals
     double maintenance_delay;
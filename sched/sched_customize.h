@@ -25,6 +25,8 @@
 // and their default values.
 //
 // ------ Shared Memory Parameters -----------
+// (for the first four: number of spare rows beyond the DB contents
+// at feeder startup)
 // #define MAX_PLATFORMS        50
 // #define MAX_APPS             10
 // #define MAX_APP_VERSIONS     50
@@ -33,7 +33,7 @@ using namespace std;
 
 #include "sched_keyword.h"
 
-JOB_KEYWORD_IDS *job_keywords_array;
+JOB_KEYWORD_IDS *job_keywords_array = NULL;
 
 // read user's KW prefs from file; return -1 if none
 //
@@ -130,8 +130,17 @@ void keyword_sched_remove_job(int i) {
     job_keywords_array[i].clear();
 }
 
-// called at CGI start to initialize job keyword array
+// called at the start of each request to initialize job keyword array.
+// Under FCGI the array is allocated once per process;
+// its entries are cleared since other processes may have
+// replaced jobs in the array since the last request.
 //
 void keyword_sched_init() {
-    job_keywords_array = new JOB_KEYWORD_IDS[ssp->max_wu_results];
+    if (!job_keywords_array) {
+        job_keywords_array = new JOB_KEYWORD_IDS[ssp->max_wu_results];
+        return;
+    }
+    for (int i=0; i<ssp->max_wu_results; i++) {
+        job_keywords_array[i].clear();
+    }
 }
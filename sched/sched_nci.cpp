@@ -64,7 +64,6 @@ static int send_job_for_app(APP& app) {
     BEST_APP_VERSION* bavp;
     SCHED_DB_RESULT result;
 
-    lock_sema();
     for (int i=0; i<ssp->max_wu_results; i++) {
         WU_RESULT& wu_result = ssp->wu_results[i];
         if (wu_result.state != WR_STATE_PRESENT && wu_result.state != g_pid) {
@@ -84,14 +83,24 @@ static int send_job_for_app(APP& app) {
             // All jobs for a given NCI app are identical.
             // If we can't send one, we can't send any.
             //
-            unlock_sema();
             log_messages.printf(MSG_NORMAL,
                 "can_send_nci() failed for NCI job\n"
             );
             return -1;
         }
-        wu_result.state = g_pid;
-        unlock_sema();
+
+        // reserve the slot; if another process got it first, keep looking.
+        // Make sure the feeder didn't replace the job in the meantime.
+        //
+        if (wu_result.state != g_pid) {
+            if (!wu_result.change_state(WR_STATE_PRESENT, g_pid)) {
+                continue;
+            }
+            if (wu_result.workunit.id != wu.id) {
+                wu_result.state = WR_STATE_PRESENT;
+                continue;
+            }
+        }
         result.id = wu_result.resultid;
         wu_result.state = WR_STATE_EMPTY;
         if (result_still_sendable(result, wu)) {
@@ -106,12 +115,10 @@ static int send_job_for_app(APP& app) {
         log_messages.printf(MSG_NORMAL,
             "NCI job was not still sendable\n"
         );
-        lock_sema();
     }
     log_messages.printf(MSG_NORMAL,
         "no sendable NCI jobs for %s\n", app.user_friendly_name
     );
-    unlock_sema();
     return 1;
 }
 
@@ -31,6 +31,7 @@
 
 #include "sched_result.h"
 #include <ctime>
+#include <set>
 
 // got a SUCCESS result; double max jobs per day.
 // TODO: shouldn't we do this only for valid results?
@@ -97,6 +98,50 @@ static inline void got_bad_result(SCHED_RESULT_ITEM& sri) {
     havp->consecutive_valid = 0;
 }
 
+// max # of results, and max total size of their stderr_out and xml_doc_out,
+// to update in one SQL statement.
+// The latter keeps the query well under MySQL's max_allowed_packet.
+//
+#define RESULT_UPDATE_BATCH_SIZE    100
+#define RESULT_UPDATE_BATCH_BYTES   (1024*1024)
+
+// write a batch of results to the DB,
+// and ack the ones that were written (or no longer exist)
+//
+static void update_result_batch(
+    DB_SCHED_RESULT_ITEM_SET& result_handler,
+    vector<SCHED_RESULT_ITEM*>& batch
+) {
+    int retval = result_handler.update_results(batch);
+    if (retval == 0 || retval == ERR_DB_NOT_FOUND) {
+        for (SCHED_RESULT_ITEM* srip: batch) {
+            g_reply->result_acks.push_back(std::string(srip->name));
+        }
+        return;
+    }
+    if (batch.size() > 1) {
+        log_messages.printf(MSG_CRITICAL,
+            "[HOST#%lu] can't update %d results in one query: %s\n",
+            g_reply->host.id, (int)batch.size(), boinc_db.error_string()
+        );
+    }
+    for (SCHED_RESULT_ITEM* srip: batch) {
+        SCHED_RESULT_ITEM& sri = *srip;
+        if (batch.size() > 1) {
+            retval = result_handler.update_result(sri);
+        }
+        if (retval) {
+            log_messages.printf(MSG_CRITICAL,
+                "[HOST#%lu] [RESULT#%lu] [WU#%lu] can't update result: %s\n",
+                g_reply->host.id, sri.id, sri.workunitid, boinc_db.error_string()
+            );
+        }
+        if (retval == 0 || retval == ERR_DB_NOT_FOUND) {
+            g_reply->result_acks.push_back(std::string(sri.name));
+        }
+    }
+}
+
 // handle completed results
 //
 int handle_results() {
@@ -417,21 +462,27 @@ int handle_results() {
     } // loop over all incoming results
 
     // Update the result records
-    // (skip items that we previously marked to skip)
+    // (skip items that we previously marked to skip).
+    // Do this in batches, one SQL statement per batch;
+    // if a batch fails, fall back to updating its results one at a time.
     //
+    vector<SCHED_RESULT_ITEM*> batch;
+    size_t batch_bytes = 0;
     for (SCHED_RESULT_ITEM& sri: result_handler.results) {
         if (sri.id == 0) continue;
-        retval = result_handler.update_result(sri);
-        if (retval) {
-            log_messages.printf(MSG_CRITICAL,
-                "[HOST#%lu] [RESULT#%lu] [WU#%lu] can't update result: %s\n",
-                g_reply->host.id, sri.id, sri.workunitid, boinc_db.error_string()
-            );
-        }
-        if (retval == 0 || retval == ERR_DB_NOT_FOUND) {
-            g_reply->result_acks.push_back(std::string(sri.name));
+        batch.push_back(&sri);
+        batch_bytes += strlen(sri.stderr_out) + strlen(sri.xml_doc_out);
+        if (batch.size() >= RESULT_UPDATE_BATCH_SIZE
+            || batch_bytes >= RESULT_UPDATE_BATCH_BYTES
+        ) {
+            update_result_batch(result_handler, batch);
+            batch.clear();
+            batch_bytes = 0;
         }
     }
+    if (batch.size()) {
+        update_result_batch(result_handler, batch);
+    }
 
     // set transition_time for the results' WUs
     //
@@ -441,6 +492,20 @@ int handle_results() {
             "[HOST#%lu] can't update WUs: %s\n",
             g_reply->host.id, boincerror(retval)
         );
+    } else if (config.wu_queue) {
+        std::set<DB_ID_TYPE> wu_set;
+        for (SCHED_RESULT_ITEM& sri: result_handler.results) {
+            if (sri.id) wu_set.insert(sri.workunitid);
+        }
+        vector<DB_ID_TYPE> wuids(wu_set.begin(), wu_set.end());
+        DB_WU_QUEUE wu_queue;
+        retval = wu_queue.add(WU_QUEUE_TRANSITIONER, wuids);
+        if (retval) {
+            log_messages.printf(MSG_CRITICAL,
+                "[HOST#%lu] can't queue WUs for transitioner: %s\n",
+                g_reply->host.id, boincerror(retval)
+            );
+        }
     }
     return 0;
 }
@@ -239,10 +239,16 @@ void send_work_score_type(int rt) {
         if (wu_result.state != WR_STATE_PRESENT  && wu_result.state != g_pid) {
             continue;
         }
-        WORKUNIT wu = wu_result.workunit;
+        // Use the job in shared memory rather than a copy;
+        // WORKUNIT is large (it includes xml_doc)
+        // and copying it for every slot dominates the scan.
+        // We copy it below only for jobs that need it.
+        //
+        const WORKUNIT& wu = wu_result.workunit;
         JOB job;
 
         job.app = ssp->lookup_app(wu.appid);
+        if (!job.app) continue;
         if (job.app->non_cpu_intensive) {
             if (config.debug_send_job) {
                 log_messages.printf(MSG_NORMAL,
@@ -273,8 +279,9 @@ void send_work_score_type(int rt) {
         // it it's a BUDA job, pick a variant using the requested resource
         //
         if (job_is_buda) {
+            WORKUNIT buda_wu = wu;
             if (!choose_buda_variant(
-                wu, rt, &(job.buda_variant), job.host_usage
+                buda_wu, rt, &(job.buda_variant), job.host_usage
             )) {
                 continue;
             }
@@ -305,7 +312,6 @@ void send_work_score_type(int rt) {
 
     std::sort(jobs.begin(), jobs.end(), job_compare);
 
-    bool sema_locked = false;
     for (JOB& job: jobs) {
 
         // check limit on total jobs
@@ -342,19 +348,22 @@ void send_work_score_type(int rt) {
             break;
         }
 
-        if (!sema_locked) {
-            lock_sema();
-            sema_locked = true;
+        // reserve the slot (unless no_work() already did)
+        // by atomically changing its state from PRESENT to our PID.
+        //
+        WU_RESULT& wu_result = ssp->wu_results[job.index];
+        bool reserved = false;
+        if (wu_result.state != g_pid) {
+            if (!wu_result.change_state(WR_STATE_PRESENT, g_pid)) {
+                continue;
+            }
+            reserved = true;
         }
 
         // make sure the job is still in the cache
-        // array is locked at this point.
         //
-        WU_RESULT& wu_result = ssp->wu_results[job.index];
-        if (wu_result.state != WR_STATE_PRESENT  && wu_result.state != g_pid) {
-            continue;
-        }
         if (wu_result.resultid != job.result_id) {
+            if (reserved) wu_result.state = WR_STATE_PRESENT;
             continue;
         }
         WORKUNIT wu = wu_result.workunit;
@@ -367,16 +376,13 @@ void send_work_score_type(int rt) {
         );
 
         if (retval) {
+            if (reserved) wu_result.state = WR_STATE_PRESENT;
             continue;
         }
-        wu_result.state = g_pid;
 
         // It passed fast checks.
-        // Release sema and do slow checks
+        // Do slow checks
         //
-        unlock_sema();
-        sema_locked = false;
-
         switch (slow_check(wu_result, job.app, job.bavp)) {
         case CHECK_NO_HOST:
             wu_result.state = WR_STATE_PRESENT;
@@ -425,9 +431,6 @@ void send_work_score_type(int rt) {
             break;
         }
     }
-    if (sema_locked) {
-        unlock_sema();
-    }
 
     restore_others(rt);
     g_wreq->best_app_versions.clear();
@@ -40,20 +40,82 @@ using std::string;
 #include "sched_util.h"
 #include "sched_shmem.h"
 
-void SCHED_SHMEM::init(int nwu_results) {
-    int size = sizeof(SCHED_SHMEM) + nwu_results*sizeof(WU_RESULT);
-    memset(this, 0, size);
+// Get table sizes based on the current number of DB rows.
+// The DB must be open.
+//
+int SCHED_SHMEM_SIZES::get_from_db(int nwu_results) {
+    DB_PLATFORM platform;
+    DB_APP app;
+    DB_APP_VERSION app_version;
+    DB_ASSIGNMENT assignment;
+    long n;
+    int retval;
+
+    retval = platform.count(n, "where deprecated=0");
+    if (retval) return retval;
+    max_platforms = n + MAX_PLATFORMS;
+    retval = app.count(n, "where deprecated=0");
+    if (retval) return retval;
+    max_apps = n + MAX_APPS;
+    retval = app_version.count(n, "where deprecated=0");
+    if (retval) return retval;
+    max_app_versions = n + MAX_APP_VERSIONS;
+    retval = assignment.count(n, "where multi <> 0");
+    if (retval) return retval;
+    max_assignments = n + MAX_ASSIGNMENTS;
+    max_wu_results = nwu_results;
+    return 0;
+}
+
+size_t SCHED_SHMEM_SIZES::segment_size() {
+    return sizeof(SCHED_SHMEM)
+        + max_platforms*sizeof(PLATFORM)
+        + max_apps*sizeof(APP)
+        + max_app_versions*sizeof(APP_VERSION)
+        + max_assignments*sizeof(ASSIGNMENT)
+        + max_wu_results*sizeof(WU_RESULT);
+}
+
+void SCHED_SHMEM::init(SCHED_SHMEM_SIZES& sizes) {
+    size_t size = sizes.segment_size();
+    memset((void*)this, 0, size);
     ss_size = size;
     platform_size = sizeof(PLATFORM);
     app_size = sizeof(APP);
     app_version_size = sizeof(APP_VERSION);
     assignment_size = sizeof(ASSIGNMENT);
     wu_result_size = sizeof(WU_RESULT);
-    max_platforms = MAX_PLATFORMS;
-    max_apps = MAX_APPS;
-    max_app_versions = MAX_APP_VERSIONS;
-    max_assignments = MAX_ASSIGNMENTS;
-    max_wu_results = nwu_results;
+    max_platforms = sizes.max_platforms;
+    max_apps = sizes.max_apps;
+    max_app_versions = sizes.max_app_versions;
+    max_assignments = sizes.max_assignments;
+    max_wu_results = sizes.max_wu_results;
+
+    char* p = (char*)(this+1);
+    platforms.set(p);
+    p += max_platforms*sizeof(PLATFORM);
+    apps.set(p);
+    p += max_apps*sizeof(APP);
+    app_versions.set(p);
+    p += max_app_versions*sizeof(APP_VERSION);
+    assignments.set(p);
+    p += max_assignments*sizeof(ASSIGNMENT);
+    wu_results.set(p);
+}
+
+// Clear the tables of an existing segment (on reread_db).
+// Schedulers may be attached,
+// so leave the header, capacities and array offsets alone.
+//
+void SCHED_SHMEM::clear_tables() {
+    nplatforms = 0;
+    napps = 0;
+    app_weight_sum = 0;
+    napp_versions = 0;
+    nassignments = 0;
+    locality_sched_lite = false;
+    have_nci_app = false;
+    memset((void*)(this+1), 0, ss_size - sizeof(SCHED_SHMEM));
 }
 
 static int error_return(const char* p, int expe, int got) {
@@ -77,21 +139,18 @@ int SCHED_SHMEM::verify() {
     if (wu_result_size != sizeof(WU_RESULT)) {
         return error_return("wu_result", sizeof(WU_RESULT), wu_result_size);
     }
-    if (max_platforms != MAX_PLATFORMS) {
-        return error_return("max platform", MAX_PLATFORMS, max_platforms);
-    }
-    if (max_apps != MAX_APPS) {
-        return error_return("max apps", MAX_APPS, max_apps);
-    }
-    if (max_app_versions != MAX_APP_VERSIONS) {
-        return error_return("max app versions", MAX_APP_VERSIONS, max_app_versions);
-    }
-    if (max_assignments != MAX_ASSIGNMENTS) {
-        return error_return("max assignments", MAX_ASSIGNMENTS, max_assignments);
-    }
-    int size = sizeof(SCHED_SHMEM) + max_wu_results*sizeof(WU_RESULT);
-    if (ss_size != size) {
-        return error_return("shmem segment", size, ss_size);
+    SCHED_SHMEM_SIZES sizes;
+    sizes.max_platforms = max_platforms;
+    sizes.max_apps = max_apps;
+    sizes.max_app_versions = max_app_versions;
+    sizes.max_assignments = max_assignments;
+    sizes.max_wu_results = max_wu_results;
+    if (ss_size != sizes.segment_size()) {
+        boinc::fprintf(stderr,
+            "shmem: size mismatch in shmem segment: expected %lu, got %lu\n",
+            (unsigned long)sizes.segment_size(), (unsigned long)ss_size
+        );
+        return ERR_SCHED_SHMEM;
     }
     return 0;
 }
@@ -99,9 +158,9 @@ int SCHED_SHMEM::verify() {
 static void overflow(const char* table, const char* param_name) {
     log_messages.printf(MSG_CRITICAL,
         "The SCHED_SHMEM structure is too small for the %s table.\n"
-        "Either increase the %s parameter in sched_shmem.h and recompile,\n"
-        "or prune old rows from the table.\n"
-        "Then restart the project.\n",
+        "Restart the project; the table will be sized to the DB.\n"
+        "If you often add rows while the project is running,\n"
+        "increase the %s parameter in sched_shmem.h and recompile.\n",
         table, param_name
     );
     exit(1);
@@ -118,17 +177,17 @@ int SCHED_SHMEM::scan_tables() {
 
     n = 0;
     while (!platform.enumerate("where deprecated=0")) {
-        platforms[n++] = platform;
-        if (n == MAX_PLATFORMS) {
+        if (n == max_platforms) {
             overflow("platforms", "MAX_PLATFORMS");
         }
+        platforms[n++] = platform;
     }
     nplatforms = n;
 
     n = 0;
     app_weight_sum = 0;
     while (!app.enumerate("where deprecated=0")) {
-        if (n == MAX_APPS) {
+        if (n == max_apps) {
             overflow("apps", "MAX_APPS");
         }
         app_weight_sum += app.weight;
@@ -225,10 +284,10 @@ int SCHED_SHMEM::scan_tables() {
                     av1.max_core_version *= 100;
                 }
 
-                app_versions[n++] = av1;
-                if (n == MAX_APP_VERSIONS) {
+                if (n == max_app_versions) {
                     overflow("app_versions", "MAX_APP_VERSIONS");
                 }
+                app_versions[n++] = av1;
             }
         }
     }
@@ -253,10 +312,10 @@ int SCHED_SHMEM::scan_tables() {
 
     n = 0;
     while (!assignment.enumerate("where multi <> 0")) {
-        assignments[n++] = assignment;
-        if (n == MAX_ASSIGNMENTS) {
+        if (n == max_assignments) {
             overflow("assignments", "MAX_ASSIGNMENTS");
         }
+        assignments[n++] = assignment;
     }
     nassignments = n;
 
@@ -325,8 +384,8 @@ APP_VERSION* SCHED_SHMEM::lookup_app_version_platform_plan_class(
 bool SCHED_SHMEM::no_work(int pid) {
     if (!ready) return true;
     for (int i=0; i<max_wu_results; i++) {
-        if (wu_results[i].state == WR_STATE_PRESENT) {
-            wu_results[i].state = pid;
+        if (wu_results[i].state != WR_STATE_PRESENT) continue;
+        if (wu_results[i].change_state(WR_STATE_PRESENT, pid)) {
             return false;
         }
     }
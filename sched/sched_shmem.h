@@ -30,9 +30,11 @@
 #include "hr_info.h"
 #include "sched_customize.h"
 
-// the following must be at least as large as DB tables
-// (counting only non-deprecated entries for the current major version)
-// Increase as needed
+// The platform, app, app version and assignment tables
+// are sized when the feeder starts:
+// each has room for the number of (non-deprecated) DB rows at that time,
+// plus the following number of additional rows
+// (which may be added before the feeder is restarted, using reread_db).
 //
 #ifndef MAX_PLATFORMS
 #define MAX_PLATFORMS       50
@@ -62,6 +64,28 @@
 #define WR_STATE_PRESENT 1
 // If neither of the above, the value is the PID of a scheduler process
 // that has this item reserved
+//
+// State transitions are done with atomic compare-and-swap
+// (see WU_RESULT::change_state()) rather than under a semaphore:
+// EMPTY -> PRESENT     feeder, after filling in the slot
+// PRESENT -> EMPTY     feeder, when purging a stale item
+// PRESENT -> PID       scheduler, to reserve the item
+// PID -> PRESENT/EMPTY scheduler that has it reserved
+// PID -> PRESENT       feeder, if the process no longer exists
+
+// An array stored elsewhere in the shared-memory segment.
+// The segment may be mapped at different addresses in different processes,
+// so instead of a pointer we store the array's offset from this object.
+//
+template <class T> struct SHMEM_ARRAY {
+    long offset;
+    inline T& operator[](int i) {
+        return ((T*)((char*)this + offset))[i];
+    }
+    inline void set(void* p) {
+        offset = (char*)p - (char*)this;
+    }
+};
 
 // a workunit/result pair
 struct WU_RESULT {
@@ -76,15 +100,38 @@ struct WU_RESULT {
     int res_server_state;
     double res_report_deadline;
     double fpops_size;      // measured in stdevs
+
+    // atomically change state from old_state to new_state.
+    // Return false (and do nothing) if state isn't old_state.
+    // This is also a full memory barrier,
+    // so other fields written before it are visible to other processes.
+    //
+    inline bool change_state(int old_state, int new_state) {
+        return __sync_bool_compare_and_swap(&state, old_state, new_state);
+    }
+};
+
+// the capacities of the tables in a SCHED_SHMEM segment
+//
+struct SCHED_SHMEM_SIZES {
+    int max_platforms;
+    int max_apps;
+    int max_app_versions;
+    int max_assignments;
+    int max_wu_results;
+
+    int get_from_db(int nwu_results);
+    size_t segment_size();
 };
 
-// this struct is followed in memory by an array of WU_RESULTS
+// this struct is followed in memory by the platform, app, app version,
+// assignment and WU_RESULT arrays.
 //
 struct SCHED_SHMEM {
     bool ready;             // feeder sets to true when init done
         // the following fields let the scheduler make sure
         // that the shared mem has the right format
-    int ss_size;            // size of this struct, including WU_RESULT array
+    size_t ss_size;         // size of segment, including arrays
     int platform_size;      // sizeof(PLATFORM)
     int app_size;           // sizeof(APP)
     int app_version_size;   // sizeof(APP_VERSION)
@@ -104,18 +151,14 @@ struct SCHED_SHMEM {
     bool have_nci_app;
     bool have_apps_for_proc_type[NPROC_TYPES];
     PERF_INFO perf_info;
-    PLATFORM platforms[MAX_PLATFORMS];
-    APP apps[MAX_APPS];
-    APP_VERSION app_versions[MAX_APP_VERSIONS];
-    ASSIGNMENT assignments[MAX_ASSIGNMENTS];
-// zero size arrays are defined differently since C++11
-#if defined(__cplusplus) && (__cplusplus >= 201103L)
-    WU_RESULT wu_results[];
-#else
-    WU_RESULT wu_results[0];
-#endif
+    SHMEM_ARRAY<PLATFORM> platforms;
+    SHMEM_ARRAY<APP> apps;
+    SHMEM_ARRAY<APP_VERSION> app_versions;
+    SHMEM_ARRAY<ASSIGNMENT> assignments;
+    SHMEM_ARRAY<WU_RESULT> wu_results;
 
-    void init(int nwu_results);
+    void init(SCHED_SHMEM_SIZES&);
+    void clear_tables();
     int verify();
     int scan_tables();
     bool no_work(int pid);
@@ -0,0 +1,192 @@
+// This file is part of BOINC.
+// https://boinc.berkeley.edu
+// Copyright (C) 2026 University of California
+//
+// BOINC is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+// BOINC is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with BOINC.  If not, see <http://www.gnu.org/licenses/>.
+
+// Contention test for reserving slots in the shared-memory work array.
+// Doesn't need a project, feeder, or DB.
+//
+// Creates a synthetic work array in anonymous shared memory,
+// and forks N processes that act like schedulers:
+// they scan the array from a random offset,
+// reserve a PRESENT slot, and mark it EMPTY.
+// The parent acts like the feeder, refilling EMPTY slots.
+// At the end we report jobs dispatched per second,
+// and check that no job was dispatched twice.
+//
+// usage: sched_shmem_test [options]
+//  --nprocs N      number of scheduler processes (default 16)
+//  --nslots N      size of work array (default 1000)
+//  --njobs N       number of jobs to dispatch (default 1000000)
+//  --sema          reserve slots under a semaphore
+//                  (the way it was done before change_state())
+
+#include "config.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "synch.h"
+#include "util.h"
+
+#include "sched_shmem.h"
+
+int nprocs = 16;
+int nslots = 1000;
+int njobs = 1000000;
+bool use_sema = false;
+key_t sema_key;
+
+WU_RESULT* wu_results;
+unsigned char* ndispatched;
+    // per job, # of times dispatched
+int* nfilled;
+    // # of jobs added to the array so far
+
+static bool reserve_slot(WU_RESULT& wr, int pid) {
+    if (use_sema) {
+        bool ok = false;
+        lock_semaphore(sema_key);
+        if (wr.state == WR_STATE_PRESENT) {
+            wr.state = pid;
+            ok = true;
+        }
+        unlock_semaphore(sema_key);
+        return ok;
+    }
+    return wr.change_state(WR_STATE_PRESENT, pid);
+}
+
+// act like a scheduler: repeatedly scan the array and dispatch jobs,
+// until the feeder has added all of them and the array is empty
+//
+static void scheduler(int pid) {
+    srand(pid);
+    while (1) {
+        bool found = false;
+        int off = rand() % nslots;
+        for (int j=0; j<nslots; j++) {
+            WU_RESULT& wr = wu_results[(j+off)%nslots];
+            if (wr.state != WR_STATE_PRESENT) continue;
+            if (!reserve_slot(wr, pid)) continue;
+            __sync_fetch_and_add(&ndispatched[wr.resultid], 1);
+            wr.state = WR_STATE_EMPTY;
+            found = true;
+            break;
+        }
+        if (!found && *nfilled == njobs) break;
+    }
+    exit(0);
+}
+
+// act like the feeder: fill empty slots until all jobs are added
+//
+static void feeder() {
+    while (*nfilled < njobs) {
+        for (int i=0; i<nslots && *nfilled<njobs; i++) {
+            WU_RESULT& wr = wu_results[i];
+            if (wr.state != WR_STATE_EMPTY) continue;
+            wr.resultid = *nfilled;
+            wr.change_state(WR_STATE_EMPTY, WR_STATE_PRESENT);
+            (*nfilled)++;
+        }
+    }
+}
+
+static void usage() {
+    fprintf(stderr,
+        "usage: sched_shmem_test [--nprocs N] [--nslots N] [--njobs N] [--sema]\n"
+    );
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    int i;
+    for (i=1; i<argc; i++) {
+        if (!strcmp(argv[i], "--nprocs")) {
+            if (++i >= argc) usage();
+            nprocs = atoi(argv[i]);
+        } else if (!strcmp(argv[i], "--nslots")) {
+            if (++i >= argc) usage();
+            nslots = atoi(argv[i]);
+        } else if (!strcmp(argv[i], "--njobs")) {
+            if (++i >= argc) usage();
+            njobs = atoi(argv[i]);
+        } else if (!strcmp(argv[i], "--sema")) {
+            use_sema = true;
+        } else {
+            usage();
+        }
+    }
+    if (nprocs < 1 || nslots < 1 || njobs < 1) usage();
+
+    size_t size = nslots*sizeof(WU_RESULT) + njobs + sizeof(int);
+    void* p = mmap(
+        NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0
+    );
+    if (p == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    memset(p, 0, size);
+    wu_results = (WU_RESULT*)p;
+    nfilled = (int*)(wu_results + nslots);
+    ndispatched = (unsigned char*)(nfilled + 1);
+
+    if (use_sema) {
+        sema_key = 0xbc000000 | (getpid() & 0xffffff);
+        if (create_semaphore(sema_key)) {
+            fprintf(stderr, "can't create semaphore\n");
+            exit(1);
+        }
+    }
+
+    double start = dtime();
+    for (i=0; i<nprocs; i++) {
+        int pid = fork();
+        if (pid == 0) {
+            scheduler(getpid());
+        }
+    }
+    feeder();
+    for (i=0; i<nprocs; i++) {
+        wait(NULL);
+    }
+    double elapsed = dtime() - start;
+
+    if (use_sema) {
+        destroy_semaphore(sema_key);
+    }
+
+    int nmissed = 0, nduplicate = 0;
+    for (i=0; i<njobs; i++) {
+        if (ndispatched[i] == 0) nmissed++;
+        if (ndispatched[i] > 1) nduplicate++;
+    }
+    printf("%s: %d procs, %d slots, %d jobs in %.2f sec (%.0f jobs/sec)\n",
+        use_sema?"semaphore":"compare-and-swap",
+        nprocs, nslots, njobs, elapsed, njobs/elapsed
+    );
+    if (nmissed || nduplicate) {
+        printf("ERROR: %d jobs not dispatched, %d dispatched more than once\n",
+            nmissed, nduplicate
+        );
+        return 1;
+    }
+    return 0;
+}
@@ -25,7 +25,18 @@
 //   [ --d x ]               debug level x
 //   [ --mod n i ]           process only WUs with (id mod n) == i
 //   [ --sleep_interval x ]  sleep x seconds if nothing to do
+//   [ --scan_interval x ]   if <wu_queue> is set, scan for WUs whose
+//                           transition time has passed every x seconds
+//   [ --txn_size n ]        do the DB writes of n WUs in one transaction
 //   [ --wu_id n ]           transition WU n (debugging)
+//
+// If <wu_queue> is set in config.xml, the scheduler, validator,
+// assimilator and create_work add WUs that need a transition
+// to the wu_queue table.
+// In that case we handle queued WUs as soon as they appear
+// (polling the queue every second by default),
+// and scan the workunit table by transition time only every
+// scan_interval seconds, mainly to catch result timeouts.
 
 #include "config.h"
 #include <vector>
@@ -33,6 +44,7 @@
 #include <cstring>
 #include <climits>
 #include <cstdlib>
+#include <set>
 #include <string>
 #include <signal.h>
 #include <sys/time.h>
@@ -61,14 +73,53 @@
 #define SELECT_LIMIT    1000
 
 #define DEFAULT_SLEEP_INTERVAL  5
+#define DEFAULT_QUEUE_SLEEP_INTERVAL    1
+    // when using wu_queue
+#define DEFAULT_SCAN_INTERVAL   60
+
+#define DEFAULT_TXN_SIZE    50
+#define MAX_INSERT_BATCH_LEN    (1024*1024)
+    // flush pending result inserts when they get this big
 
 int startup_time;
 R_RSA_PRIVATE_KEY key;
 int mod_n, mod_i;
 bool do_mod = false;
 bool one_pass = false;
-int sleep_interval = DEFAULT_SLEEP_INTERVAL;
+int sleep_interval = 0;
+int scan_interval = DEFAULT_SCAN_INTERVAL;
 int wu_id = 0;
+int txn_size = DEFAULT_TXN_SIZE;
+
+// Results created by handle_wu() are accumulated here,
+// and inserted with a single query when the transaction is committed
+//
+std::string pending_result_values;
+int npending_results = 0;
+
+// per-pass counters
+//
+struct TRANSITIONER_STATS {
+    int nwus;
+    int nresults_created;
+    int ntxns;
+    double enum_time;       // time spent enumerating WUs and results
+    double handle_time;     // time spent in handle_wu()
+    double write_time;      // time spent inserting results and committing
+
+    void clear() {
+        memset(this, 0, sizeof(*this));
+    }
+    void print(double elapsed) {
+        log_messages.printf(MSG_NORMAL,
+            "pass: %d WUs (%.1f/sec), %d results created, %d transactions; "
+            "enumerate %.2fs, handle %.2fs, write %.2fs\n",
+            nwus, elapsed>0?nwus/elapsed:0., nresults_created, ntxns,
+            enum_time, handle_time, write_time
+        );
+    }
+};
+TRANSITIONER_STATS stats;
 
 void signal_handler(int) {
     log_messages.printf(MSG_NORMAL, "Signaled by simulator\n");
@@ -146,6 +197,54 @@ static int result_timed_out(
     return 0;
 }
 
+// insert the results created since the last call
+//
+static int flush_result_inserts() {
+    if (!npending_results) return 0;
+    double t = dtime();
+    DB_RESULT r;
+    int retval = r.insert_batch(pending_result_values);
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "insert_batch() of %d results: %s\n",
+            npending_results, boincerror(retval)
+        );
+        return retval;
+    }
+    stats.nresults_created += npending_results;
+    stats.write_time += dtime() - t;
+    pending_result_values.clear();
+    npending_results = 0;
+    return 0;
+}
+
+// insert pending results and commit the current transaction
+//
+static int commit_txn() {
+    int retval = flush_result_inserts();
+    if (retval) return retval;
+    double t = dtime();
+    retval = boinc_db.commit_transaction();
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "commit_transaction(): %s\n", boinc_db.error_string()
+        );
+        return retval;
+    }
+    stats.ntxns++;
+    stats.write_time += dtime() - t;
+    return 0;
+}
+
+// something went wrong; discard the current transaction and exit.
+// The WUs in it will be handled again, since their transition times
+// weren't updated.
+//
+static void abort_txn() {
+    boinc_db.rollback_transaction();
+    exit(1);
+}
+
 int handle_wu(
     DB_TRANSITIONER_ITEM_SET& transitioner,
     std::vector<TRANSITIONER_ITEM>& items
@@ -486,14 +585,14 @@ int handle_wu(
                     values += value_buf;
                 }
             }
-            DB_RESULT r;
-            retval = r.insert_batch(values);
-            if (retval) {
-                log_messages.printf(MSG_CRITICAL,
-                    "[WU#%lu %s] insert_batch(): %s\n",
-                    wu_item.id, wu_item.name, boincerror(retval)
-                );
-                return retval;
+            if (npending_results) {
+                pending_result_values += ",";
+            }
+            pending_result_values += values;
+            npending_results += n_new_results_needed;
+            if (pending_result_values.size() > MAX_INSERT_BATCH_LEN) {
+                retval = flush_result_inserts();
+                if (retval) return retval;
             }
         }
     }
@@ -684,15 +783,63 @@ int handle_wu(
     return 0;
 }
 
+// handle one WU, and commit if the transaction is big enough
+//
+static void transition_wu(
+    DB_TRANSITIONER_ITEM_SET& transitioner,
+    std::vector<TRANSITIONER_ITEM>& items,
+    int& nin_txn
+) {
+    int retval;
+    double t;
+
+    if (nin_txn == 0) {
+        retval = boinc_db.start_transaction();
+        if (retval) {
+            log_messages.printf(MSG_CRITICAL,
+                "start_transaction(): %s; exiting\n",
+                boinc_db.error_string()
+            );
+            exit(1);
+        }
+    }
+    TRANSITIONER_ITEM& wu_item = items[0];
+    t = dtime();
+    retval = handle_wu(transitioner, items);
+    stats.handle_time += dtime() - t;
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "[WU#%lu %s] handle_wu: %s; quitting\n",
+            wu_item.id, wu_item.name, boincerror(retval)
+        );
+        // probably better to exit here.
+        // Whatever cause this WU to fail (and it could be temporary)
+        // might cause ALL WUs to fail
+        //
+        abort_txn();
+    }
+    stats.nwus++;
+    if (++nin_txn >= txn_size) {
+        if (commit_txn()) abort_txn();
+        nin_txn = 0;
+    }
+}
+
 bool do_pass() {
     int retval;
     DB_TRANSITIONER_ITEM_SET transitioner;
     std::vector<TRANSITIONER_ITEM> items;
     bool did_something = false;
+    int nin_txn = 0;
+    double t, pass_start = dtime();
 
     if (!one_pass) check_stop_daemons();
 
-    // loop over entries that are due to be checked
+    stats.clear();
+
+    // loop over entries that are due to be checked.
+    // Group the DB writes of txn_size WUs into a transaction,
+    // so that we don't wait for a commit after each one.
     //
     while (1) {
         if (wu_id) {
@@ -700,41 +847,119 @@ bool do_pass() {
             mod_n = 1;
             mod_i = wu_id;
         }
+        t = dtime();
         retval = transitioner.enumerate(
             (int)time(0), SELECT_LIMIT, mod_n, mod_i, items
         );
+        stats.enum_time += dtime() - t;
         if (retval) {
             if (retval != ERR_DB_NOT_FOUND) {
                 log_messages.printf(MSG_CRITICAL,
                     "WU enum error: %s; exiting\n", boincerror(retval)
                 );
+                if (nin_txn) abort_txn();
                 exit(1);
             }
             break;
         }
         did_something = true;
-        TRANSITIONER_ITEM& wu_item = items[0];
-        retval = handle_wu(transitioner, items);
-        if (retval) {
-            log_messages.printf(MSG_CRITICAL,
-                "[WU#%lu %s] handle_wu: %s; quitting\n",
-                wu_item.id, wu_item.name, boincerror(retval)
-            );
-            // probably better to exit here.
-            // Whatever cause this WU to fail (and it could be temporary)
-            // might cause ALL WUs to fail
-            //
-            exit(1);
-        }
+        transition_wu(transitioner, items, nin_txn);
 
-        if (!one_pass) check_stop_daemons();
+        // check for stop only between transactions
+        //
+        if (!one_pass && nin_txn == 0) check_stop_daemons();
         if (wu_id) break;
     }
+    if (nin_txn) {
+        if (commit_txn()) abort_txn();
+    }
+    if (did_something) {
+        stats.print(dtime() - pass_start);
+    }
     return did_something;
 }
 
+// handle the WUs in the transitioner's wu_queue.
+// The queue entries are removed after the transitions are committed,
+// so if we crash they'll be handled again (which is harmless).
+//
+bool do_queue_pass() {
+    int retval;
+    DB_WU_QUEUE wu_queue;
+    std::vector<WU_QUEUE_ITEM> qitems;
+    DB_TRANSITIONER_ITEM_SET transitioner;
+    std::vector<TRANSITIONER_ITEM> items;
+    std::set<DB_ID_TYPE> wuids;
+    std::set<DB_ID_TYPE>::iterator it;
+    std::string ids;
+    char buf[256];
+    int nin_txn = 0;
+    double t, pass_start = dtime();
+
+    if (!one_pass) check_stop_daemons();
+
+    stats.clear();
+
+    t = dtime();
+    retval = wu_queue.get(
+        WU_QUEUE_TRANSITIONER, SELECT_LIMIT, mod_n, mod_i, qitems
+    );
+    stats.enum_time += dtime() - t;
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "wu_queue.get(): %s; exiting\n", boincerror(retval)
+        );
+        exit(1);
+    }
+    if (qitems.empty()) return false;
+
+    // a WU may be queued more than once; handle it once
+    //
+    for (unsigned int i=0; i<qitems.size(); i++) {
+        wuids.insert(qitems[i].wuid);
+    }
+    for (it = wuids.begin(); it != wuids.end(); ++it) {
+        sprintf(buf, "%s%lu", ids.empty()?"":",", *it);
+        ids += buf;
+    }
+
+    while (1) {
+        t = dtime();
+        retval = transitioner.enumerate_ids(ids.c_str(), items);
+        stats.enum_time += dtime() - t;
+        if (retval) {
+            if (retval != ERR_DB_NOT_FOUND) {
+                log_messages.printf(MSG_CRITICAL,
+                    "WU enum error: %s; exiting\n", boincerror(retval)
+                );
+                if (nin_txn) abort_txn();
+                exit(1);
+            }
+            break;
+        }
+        transition_wu(transitioner, items, nin_txn);
+        if (!transitioner.cursor.active) break;
+    }
+    if (nin_txn) {
+        if (commit_txn()) abort_txn();
+    }
+
+    retval = wu_queue.remove(qitems);
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "wu_queue.remove(): %s\n", boincerror(retval)
+        );
+    }
+    log_messages.printf(MSG_DEBUG,
+        "%d queue entries, %d WUs\n", (int)qitems.size(), (int)wuids.size()
+    );
+    stats.print(dtime() - pass_start);
+    return true;
+}
+
 void main_loop() {
     int retval;
+    double last_scan_time = 0;
 
     retval = boinc_db.open(config.db_name, config.db_host, config.db_user, config.db_passwd);
     if (retval) {
@@ -747,7 +972,16 @@ void main_loop() {
     while (1) {
         log_messages.printf(MSG_DEBUG, "doing a pass\n");
         if (1) {
-            bool did_something = do_pass();
+            bool did_something = false;
+            if (config.wu_queue && !wu_id) {
+                did_something = do_queue_pass();
+                if (one_pass || dtime() > last_scan_time + scan_interval) {
+                    if (do_pass()) did_something = true;
+                    last_scan_time = dtime();
+                }
+            } else {
+                did_something = do_pass();
+            }
             if (one_pass) break;
             if (did_something) continue;
 #ifdef GCL_SIMULATOR
@@ -774,9 +1008,11 @@ void usage(char *name) {
         "  [ --d x ]                       debug level x\n"
         "  [ --mod n i ]                   process only WUs with (id mod n) == i\n"
         "  [ --sleep_interval x ]          sleep x seconds if nothing to do\n"
+        "  [ --scan_interval x ]           with <wu_queue>: scan by transition time every x seconds (default %d)\n"
+        "  [ --txn_size n ]                do the DB writes of n WUs in one transaction (default %d)\n"
         "  [ -h | --help ]                 Show this help text.\n"
         "  [ -v | --version ]              Shows version information.\n",
-        name
+        name, DEFAULT_SCAN_INTERVAL, DEFAULT_TXN_SIZE
     );
 }
 
@@ -813,6 +1049,21 @@ int main(int argc, char** argv) {
                 exit(1);
             }
             sleep_interval = atoi(argv[i]);
+        } else if (is_arg(argv[i], "scan_interval")) {
+            if (!argv[++i]) {
+                log_messages.printf(MSG_CRITICAL, "%s requires an argument\n\n", argv[--i]);
+                usage(argv[0]);
+                exit(1);
+            }
+            scan_interval = atoi(argv[i]);
+        } else if (is_arg(argv[i], "txn_size")) {
+            if (!argv[++i]) {
+                log_messages.printf(MSG_CRITICAL, "%s requires an argument\n\n", argv[--i]);
+                usage(argv[0]);
+                exit(1);
+            }
+            txn_size = atoi(argv[i]);
+            if (txn_size < 1) txn_size = 1;
         } else if (is_arg(argv[i], "h") || is_arg(argv[i], "help")) {
             usage(argv[0]);
             exit(0);
@@ -835,6 +1086,9 @@ int main(int argc, char** argv) {
         log_messages.printf(MSG_CRITICAL, "Can't parse config.xml: %s\n", boincerror(retval));
         exit(1);
     }
+    if (!sleep_interval) {
+        sleep_interval = config.wu_queue?DEFAULT_QUEUE_SLEEP_INTERVAL:DEFAULT_SLEEP_INTERVAL;
+    }
 
     sprintf(path, "%s/upload_private", config.key_dir);
     std::tie(retval, key) = read_key_file(path);
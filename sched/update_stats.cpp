@@ -30,6 +30,7 @@
 //  [--update_hosts]
 //  [--update_avs]
 //  [--min_age nsec] don't update items updated more recently than this
+//  [--nprocs N]     update users and hosts using N DB connections
 
 
 #include "config.h"
@@ -37,8 +38,10 @@
 #include <cstring>
 #include <string>
 #include <cstdlib>
+#include <cmath>
 #include <ctime>
 #include <unistd.h>
+#include <sys/wait.h>
 
 #include "boinc_db.h"
 #include "util.h"
@@ -55,175 +58,140 @@
 
 #define MIN_AGE 86400
 
-double max_update_time;
+#define ID_CHUNK    100000
+    // update this many IDs per SQL statement
 
-int update_users() {
-    DB_USER user;
-    int retval;
-    char buf[256];
+double max_update_time;
+int nprocs = 1;
+
+// Decay the average credit of items in the given table
+// whose average hasn't been updated since max_update_time.
+// This is done by the DB server, one range of IDs at a time,
+// rather than by reading and writing each row.
+// The computation is that of update_average() with no new work:
+// avg *= exp(-(now-avg_time)*ln(2)/half_life); avg_time = now.
+//
+// If nprocs > 1, this is called in nprocs processes;
+// process i does the ranges whose number mod nprocs is i.
+//
+int decay_table(const char* table_name, double min_credit, int proc) {
+    DB_BASE table(table_name, &boinc_db);
+    DB_ID_TYPE max_id;
+    char set_clause[512], where_clause[512];
     double now = dtime();
-
-    while (1) {
-        sprintf(buf, "where expavg_credit>0.1 and expavg_time < %f", max_update_time);
-        retval = user.enumerate(buf);
-        if (retval) {
-            if (retval != ERR_DB_NOT_FOUND) {
-                log_messages.printf(MSG_CRITICAL, "lost DB conn\n");
-                exit(1);
-            }
-            break;
-        }
-        update_average(
-            now, 0, 0, CREDIT_HALF_LIFE, user.expavg_credit, user.expavg_time
-        );
-        sprintf( buf, "expavg_credit=%f, expavg_time=%f",
-            user.expavg_credit, user.expavg_time
-        );
-        retval = user.update_field(buf);
-        if (retval) {
-            log_messages.printf(MSG_CRITICAL, "Can't update user %lu\n", user.id);
-            return retval;
-        }
-    }
-    return 0;
-}
-
-int update_avs() {
-    DB_APP_VERSION av;
+    long nupdated = 0;
     int retval;
-    char buf[256];
-    double now = dtime();
 
-    sprintf(buf, "where expavg_credit>0 and expavg_time < %f", max_update_time);
-    while (1) {
-        retval = av.enumerate(buf);
-        if (retval) {
-            if (retval == ERR_DB_NOT_FOUND) {
-                break;
-            }
-            log_messages.printf(MSG_CRITICAL, "lost DB conn\n");
-            exit(1);
-        }
-        update_average(
-            now, 0, 0, CREDIT_HALF_LIFE, av.expavg_credit, av.expavg_time
-        );
-        char buf2[256];
-        sprintf(buf2, "expavg_credit=%f, expavg_time=%f",
-            av.expavg_credit, av.expavg_time
+    retval = table.max_id(max_id);
+    if (retval) return retval;
+
+    // MySQL does the assignments in order,
+    // so expavg_credit is computed with the old expavg_time
+    //
+    sprintf(set_clause,
+        "expavg_credit = if(expavg_time>0, "
+        "expavg_credit*exp(-greatest(0, %f-expavg_time)*%.15e), "
+        "expavg_credit), "
+        "expavg_time = %f",
+        now, M_LN2/CREDIT_HALF_LIFE, now
+    );
+    for (DB_ID_TYPE start=0, i=0; start<=max_id; start+=ID_CHUNK, i++) {
+        if (i % nprocs != proc) continue;
+        sprintf(where_clause,
+            "id between %lu and %lu and expavg_credit>%f and expavg_time<%f",
+            start, start+ID_CHUNK-1, min_credit, max_update_time
         );
-        retval = av.update_field(buf2);
+        retval = table.update_fields_noid(set_clause, where_clause);
         if (retval) {
             log_messages.printf(MSG_CRITICAL,
-                "Can't update app version %lu\n", av.id
+                "can't update %s: %s\n", table_name, boinc_db.error_string()
             );
             return retval;
         }
+        nupdated += boinc_db.affected_rows();
     }
+    log_messages.printf(MSG_NORMAL,
+        "decayed credit of %ld %s records in %.1f sec\n",
+        nupdated, table_name, dtime()-now
+    );
     return 0;
 }
 
-int update_hosts() {
-    DB_HOST host;
-    int retval;
-    char buf[256];
-    double now = dtime();
+// do decay_table() in nprocs processes, each with its own DB connection
+//
+int decay_table_parallel(const char* table_name, double min_credit) {
+    int i, status, retval = 0;
 
-    while (1) {
-        sprintf(buf, "where expavg_credit>0.1 and expavg_time < %f", max_update_time);
-        retval = host.enumerate(buf);
-        if (retval) {
-            if (retval != ERR_DB_NOT_FOUND) {
-                log_messages.printf(MSG_CRITICAL, "lost DB conn\n");
-                exit(1);
+    if (nprocs == 1) {
+        return decay_table(table_name, min_credit, 0);
+    }
+    for (i=0; i<nprocs; i++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            log_messages.printf(MSG_CRITICAL, "fork() failed\n");
+            exit(1);
+        }
+        if (pid == 0) {
+            // don't use the parent's connection
+            //
+            retval = boinc_db.open(
+                config.db_name, config.db_host, config.db_user,
+                config.db_passwd
+            );
+            if (retval) {
+                log_messages.printf(MSG_CRITICAL, "Can't open DB: %s\n",
+                    boinc_db.error_string()
+                );
+                _exit(1);
             }
-            break;
+            retval = decay_table(table_name, min_credit, i);
+            boinc_db.close();
+            _exit(retval?1:0);
         }
-        update_average(
-            now, 0, 0, CREDIT_HALF_LIFE, host.expavg_credit, host.expavg_time
-        );
-        sprintf(
-            buf,"expavg_credit=%f, expavg_time=%f",
-            host.expavg_credit, host.expavg_time
-        );
-        retval = host.update_field(buf);
-        if (retval) {
-            log_messages.printf(MSG_CRITICAL, "Can't update host %lu\n", host.id);
-            return retval;
+    }
+    for (i=0; i<nprocs; i++) {
+        if (wait(&status) < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) {
+            retval = ERR_DB_CONN_LOST;
         }
     }
-
-    return 0;
+    return retval;
 }
 
-int get_team_totals(TEAM& team) {
-    long nusers;
-    int retval;
-    DB_USER user;
-    char buf[256];
-
-    // count the number of users on the team
-    //
-    sprintf(buf, "where teamid=%lu", team.id);
-    retval = user.count(nusers, buf);
-    if (retval) return retval;
+int update_users() {
+    return decay_table_parallel("user", 0.1);
+}
 
-    if (team.nusers != nusers) {
-        log_messages.printf(MSG_CRITICAL,
-            "updating member count for [TEAM#%lu]: database has %d users, count shows %ld\n",
-            team.id, team.nusers, nusers
-        );
-    }
-    team.nusers = nusers;
+int update_avs() {
+    return decay_table("app_version", 0, 0);
+}
 
-    return 0;
+int update_hosts() {
+    return decay_table_parallel("host", 0.1);
 }
 
-// fill in the nusers, total_credit and expavg_credit fields
-// of the team table.
-// This may take a while; don't do it often
+// Update the nusers and expavg_credit fields of the team table.
+// nusers is computed for all teams with one aggregate query.
 //
 int update_teams() {
-    DB_TEAM team;
     int retval;
-    char buf[256];
-    double now = dtime();
 
-    while (1) {
-        retval = team.enumerate("where expavg_credit>0.1");
-        if (retval) {
-            if (retval != ERR_DB_NOT_FOUND) {
-                log_messages.printf(MSG_CRITICAL, "lost DB conn\n");
-                exit(1);
-            }
-            break;
-        }
-
-        retval = get_team_totals(team);
-        if (retval) {
-            log_messages.printf(MSG_CRITICAL,
-                "update_teams: get_team_credit([TEAM#%lu]) failed: %d\n",
-                team.id,
-                retval
-            );
-            continue;
-        }
-        if (team.expavg_time < max_update_time) {
-            update_average(
-                now, 0, 0, CREDIT_HALF_LIFE, team.expavg_credit,
-                team.expavg_time
-            );
-        }
-        sprintf(
-            buf, "expavg_credit=%f, expavg_time=%f, nusers=%d",
-            team.expavg_credit, team.expavg_time, team.nusers
+    retval = boinc_db.do_query(
+        "update team left join "
+        "(select teamid, count(*) as n from user where teamid>0 group by teamid) as u "
+        "on team.id = u.teamid "
+        "set team.nusers = ifnull(u.n, 0) "
+        "where team.expavg_credit>0.1 and team.nusers <> ifnull(u.n, 0)"
+    );
+    if (retval) {
+        log_messages.printf(MSG_CRITICAL,
+            "can't update team member counts: %s\n", boinc_db.error_string()
         );
-        retval = team.update_field(buf);
-        if (retval) {
-            log_messages.printf(MSG_CRITICAL, "Can't update team %lu\n", team.id);
-            return retval;
-        }
+        return retval;
     }
-    return 0;
+    log_messages.printf(MSG_NORMAL,
+        "updated member count of %d teams\n", boinc_db.affected_rows()
+    );
+    return decay_table("team", 0.1, 0);
 }
 
 void usage(char *name) {
@@ -241,6 +209,8 @@ void usage(char *name) {
         "  [ --update_users ]              Update users\n"
         "  [ --update_hosts ]              Update hosts\n"
         "  [ --update_avs ]                Update app versions\n"
+        "  [ --min_age nsec ]              Don't update items updated more recently than this\n"
+        "  [ --nprocs N ]                  Update users and hosts using N DB connections\n"
         "  [ -h | --help ]                 Shows this text\n"
         "  [ -v | --version ]              Shows version\n",
         name
@@ -270,6 +240,14 @@ int main(int argc, char** argv) {
         } else if (is_arg(argv[i], "min_age")) {
             double x = atof(argv[++i]);
             max_update_time = time(0) - x;
+        } else if (is_arg(argv[i], "nprocs")) {
+            if (!argv[++i]) {
+                log_messages.printf(MSG_CRITICAL, "%s requires an argument\n\n", argv[--i]);
+                usage(argv[0]);
+                exit(1);
+            }
+            nprocs = atoi(argv[i]);
+            if (nprocs < 1) nprocs = 1;
         } else if (!strcmp(argv[i], "-d")) {
             if (!argv[++i]) {
                 log_messages.printf(MSG_CRITICAL, "%s requires an argument\n\n", argv[--i]);
@@ -0,0 +1,87 @@
+#!/bin/sh
+
+# This file is part of BOINC.
+# https://boinc.berkeley.edu
+# Copyright (C) 2026 University of California
+#
+# BOINC is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License
+# as published by the Free Software Foundation,
+# either version 3 of the License, or (at your option) any later version.
+#
+# BOINC is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+# See the GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with BOINC.  If not, see <http://www.gnu.org/licenses/>.
+
+# Push a large upload through file_upload_handler (run as a CGI program)
+# and report the throughput.  Doesn't need a web server or a DB.
+#
+# usage: upload_bench.sh path/to/file_upload_handler [size_MB] [dir]
+#
+# size_MB defaults to 2048.
+# A scratch project is created in dir (default: a temp dir);
+# put it on the file system you want to measure.
+
+FUH=$1
+SIZE_MB=${2:-2048}
+DIR=${3:-`mktemp -d`}
+
+if [ -z "$FUH" ] || [ ! -x "$FUH" ]; then
+    echo "usage: $0 path/to/file_upload_handler [size_MB] [dir]"
+    exit 1
+fi
+FUH=`cd \`dirname $FUH\` && pwd`/`basename $FUH`
+
+mkdir -p $DIR/cgi-bin $DIR/upload || exit 1
+cat > $DIR/config.xml <<EOF
+<boinc>
+<config>
+    <upload_dir>$DIR/upload</upload_dir>
+    <uldl_dir_fanout>1024</uldl_dir_fanout>
+    <ignore_upload_certificates/>
+</config>
+</boinc>
+EOF
+
+NBYTES=`expr $SIZE_MB \* 1048576`
+NAME=upload_bench_`date +%s`
+
+# the request is an XML header followed by the file data.
+# Generate the data on the fly so that we measure the handler,
+# not the reads of a source file.
+#
+gen_request() {
+    cat <<EOF
+<data_server_request>
+<file_upload>
+<file_info>
+<name>$NAME</name>
+</file_info>
+<nbytes>$NBYTES</nbytes>
+<offset>0</offset>
+<data>
+EOF
+    head -c $NBYTES /dev/zero
+}
+
+START=`date +%s.%N`
+gen_request | (cd $DIR/cgi-bin && BOINC_PROJECT_DIR=$DIR $FUH) > $DIR/reply.txt
+END=`date +%s.%N`
+
+if ! grep -q "<status>0</status>" $DIR/reply.txt; then
+    echo "upload failed:"
+    cat $DIR/reply.txt
+    exit 1
+fi
+FOUND=`find $DIR/upload -name $NAME`
+GOT=`wc -c < $FOUND`
+if [ $GOT -ne $NBYTES ]; then
+    echo "wrong size: expected $NBYTES, got $GOT"
+    exit 1
+fi
+awk "BEGIN {t = $END - $START; printf \"%d MB in %.2f sec: %.0f MB/sec\\n\", $SIZE_MB, t, $SIZE_MB/t}"
+rm -f $FOUND
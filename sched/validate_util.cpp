@@ -22,9 +22,13 @@
 
 #include <cstring>
 #include "config.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "error_numbers.h"
 #include "filesys.h"
+#include "md5_file.h"
 #include "parse.h"
 #include "str_replace.h"
 #include "util.h"
@@ -156,6 +160,51 @@ int get_output_file_paths(RESULT const& result, vector<string>& paths) {
     return 0;
 }
 
+// Get the MD5 and size of an output file.
+// If the upload handler wrote FILENAME.md5 (see fuh_md5_info),
+// and it's consistent with the file, use it;
+// otherwise read the file.
+//
+int get_output_file_md5(const char* path, char* md5, double& nbytes) {
+    char md5_path[MAXPATHLEN], buf[MD5_LEN];
+    struct stat sbuf, md5_sbuf;
+    double n;
+
+    if (config.fuh_md5_info && !stat(path, &sbuf)) {
+        snprintf(md5_path, sizeof(md5_path), "%s.md5", path);
+        if (!stat(md5_path, &md5_sbuf) && md5_sbuf.st_mtime >= sbuf.st_mtime) {
+            FILE* f = boinc::fopen(md5_path, "r");
+            if (f) {
+                int k = boinc::fscanf(f, "%32s %lf", buf, &n);
+                boinc::fclose(f);
+                if (k == 2 && strlen(buf) == 32 && n == (double)sbuf.st_size) {
+                    strcpy(md5, buf);
+                    nbytes = n;
+                    return 0;
+                }
+            }
+        }
+    }
+    return md5_file(path, md5, nbytes);
+}
+
+// Tell the OS we're going to read the result's output files,
+// so that it starts reading them into the page cache now.
+// Missing files are ignored; the validator will deal with them.
+//
+void prefetch_output_files(RESULT const& result) {
+    vector<string> paths;
+    if (get_output_file_paths(result, paths)) return;
+    for (const string& path: paths) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) continue;
+#ifdef HAVE_POSIX_FADVISE
+        posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+        close(fd);
+    }
+}
+
 // remove the random part of an output filename:
 // given a name of the form "xxx_resultnum_r123123_filenum",
 // return "xxx_resultnum_filenum"
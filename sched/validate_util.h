@@ -46,6 +46,8 @@ extern int get_output_file_path(RESULT const& result, std::string&);
 extern int get_output_file_paths(
     RESULT const& result, std::vector<std::string>&
 );
+extern void prefetch_output_files(RESULT const& result);
+extern int get_output_file_md5(const char* path, char* md5, double& nbytes);
 extern int get_logical_name(
     RESULT& result, const std::string& path, std::string& name
 );
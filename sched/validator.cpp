@@ -49,6 +49,7 @@
 //  [--wu_id n]                 Validate WU n (debugging)
 //  [--check_punitive]          check for results with long-term failure,
 //                              punish host
+//  [--prefetch N]              read ahead the output files of N WUs
 
 #include "config.h"
 #include <unistd.h>
@@ -56,6 +57,7 @@
 #include <cmath>
 #include <ctime>
 #include <vector>
+#include <deque>
 #include <cstdlib>
 #include <string>
 #include <signal.h>
@@ -86,6 +88,7 @@ using std::vector;
 
 #define SELECT_LIMIT    1000
 #define SLEEP_PERIOD    5
+#define DEFAULT_PREFETCH    16
 
 int sleep_interval = SLEEP_PERIOD;
 
@@ -115,6 +118,7 @@ bool no_credit = false;
 bool dry_run = false;
 bool check_punitive = false;
 int wu_id = 0;
+int prefetch_depth = DEFAULT_PREFETCH;
 int g_argc;
 char **g_argv;
 
@@ -774,45 +778,87 @@ leave:
             );
             return retval;
         }
+        if (config.wu_queue && transition_time == IMMEDIATE) {
+            DB_WU_QUEUE wu_queue;
+            retval = wu_queue.add(WU_QUEUE_TRANSITIONER, wu.id);
+            if (retval) {
+                log_messages.printf(MSG_CRITICAL,
+                    "[WU#%lu %s] can't queue WU for transitioner: %s\n",
+                    wu.id, wu.name, boincerror(retval)
+                );
+            }
+        }
     }
     return 0;
 }
 
+// start reading the output files of a WU's successful results
+//
+static void prefetch_wu_files(vector<VALIDATOR_ITEM>& items) {
+    for (const VALIDATOR_ITEM& item: items) {
+        if (item.res.outcome != RESULT_OUTCOME_SUCCESS) continue;
+        prefetch_output_files(item.res);
+    }
+}
+
 // make one pass through the workunits with need_validate set.
 // return true if there were any
 //
+// We enumerate up to prefetch_depth WUs ahead of the one being validated,
+// and start reading their output files,
+// so that several file reads are in progress at once
+// rather than one per WU.
+// This is OK because enumerate() gets all the rows of a query at once;
+// the ones we read ahead are no more stale than before.
+// But once a query's rows are used up, the next enumerate() does a new query,
+// which would return the queued WUs again (they still have need_validate set).
+// So don't enumerate again until those have been handled.
+//
 bool do_validate_scan() {
     DB_VALIDATOR_ITEM_SET validator;
     std::vector<VALIDATOR_ITEM> items;
-    bool found=false;
+    std::deque<std::vector<VALIDATOR_ITEM> > queue;
+    bool found=false, enum_done=false, query_done=false;
     int retval, i=0;
 
     // loop over entries that need to be checked
     //
     while (1) {
-        if (wu_id) {
-            // kludge to tell enumerate to return a given WU
-            wu_id_modulus = 1;
-            wu_id_remainder = wu_id;
-        }
-        retval = validator.enumerate(
-            app.id, SELECT_LIMIT, wu_id_modulus, wu_id_remainder,
-            wu_id_min, wu_id_max, items
-        );
-        if (retval) {
-            if (retval != ERR_DB_NOT_FOUND) {
-                log_messages.printf(MSG_DEBUG,
-                    "DB connection lost, exiting\n"
-                );
-                exit(0);
+        while (!enum_done && !query_done && (int)queue.size() <= prefetch_depth) {
+            if (wu_id) {
+                // kludge to tell enumerate to return a given WU
+                wu_id_modulus = 1;
+                wu_id_remainder = wu_id;
+            }
+            retval = validator.enumerate(
+                app.id, SELECT_LIMIT, wu_id_modulus, wu_id_remainder,
+                wu_id_min, wu_id_max, items
+            );
+            if (retval) {
+                if (retval != ERR_DB_NOT_FOUND) {
+                    log_messages.printf(MSG_DEBUG,
+                        "DB connection lost, exiting\n"
+                    );
+                    exit(0);
+                }
+                enum_done = true;
+                break;
+            }
+            if (prefetch_depth) {
+                prefetch_wu_files(items);
             }
-            break;
+            queue.push_back(std::vector<VALIDATOR_ITEM>());
+            queue.back().swap(items);
+            if (wu_id) enum_done = true;
+            if (dry_run) enum_done = true;  // otherwise it will enumerate forever
+            if (!validator.cursor.active) query_done = true;
         }
-        retval = handle_wu(validator, items);
+        if (queue.empty()) break;
+        retval = handle_wu(validator, queue.front());
+        queue.pop_front();
+        if (queue.empty()) query_done = false;
         if (!retval) found = true;
         if (++i == one_pass_N_WU) break;
-        if (wu_id) break;
-        if (dry_run) break;  // otherwise it will enumerate forever
     }
     return found;
 }
@@ -878,11 +924,12 @@ void usage(char* name) {
         "    [--check_punitive]         Check failed results and reduce the daily quota to one.\n"
         "    [--sleep_interval n]       Set sleep-interval to n\n"
         "    [--wu_id n]                Process WU with given ID\n"
+        "    [--prefetch n]             Read ahead output files of n WUs (default %d; 0 to disable)\n"
         "    [-d level|--debug_level n] Set log verbosity level\n"
         "    [-h|--help]                Print this usage information and exit\n"
         "    [-v|--version]             Print version information and exit\n"
         "\n",
-        name
+        name, DEFAULT_PREFETCH
     );
     validate_handler_usage();
 
@@ -948,6 +995,14 @@ int main(int argc, char** argv) {
             one_pass = true;
         } else if (is_arg(argv[i], "check_punitive")) {
             check_punitive = true;
+        } else if (is_arg(argv[i], "prefetch")) {
+            if (!argv[++i]) {
+                log_messages.printf(MSG_CRITICAL, "%s requires an argument\n\n", argv[--i]);
+                usage(argv[0]);
+                exit(1);
+            }
+            prefetch_depth = atoi(argv[i]);
+            if (prefetch_depth < 0) prefetch_depth = 0;
         } else {
             // unknown arg - pass to handler
             argv[j++] = argv[i];
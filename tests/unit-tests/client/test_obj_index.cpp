@@ -0,0 +1,81 @@
+// This file is part of BOINC.
+// https://boinc.berkeley.edu
+// Copyright (C) 2026 University of California
+//
+// BOINC is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+// BOINC is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with BOINC.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdio>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../../../client/obj_index.h"
+
+namespace test_obj_index {
+    struct PROJ {
+        int id;
+    };
+
+    struct OBJ {
+        PROJ* project;
+        char name[256];
+    };
+
+    class test_obj_index : public ::testing::Test {};
+
+    // index 100k files in two projects, as when parsing a large state file
+    //
+    TEST_F(test_obj_index, large_state) {
+        const int N = 100000;
+        PROJ p1, p2;
+        std::vector<OBJ> objs(N);
+        OBJ_INDEX<OBJ> index;
+
+        for (int i=0; i<N; i++) {
+            objs[i].project = (i%2) ? &p2 : &p1;
+            snprintf(objs[i].name, sizeof(objs[i].name), "file_%d", i/2);
+            index.add(&objs[i]);
+        }
+        EXPECT_EQ((size_t)N, index.size());
+
+        for (int i=0; i<N; i++) {
+            EXPECT_EQ(&objs[i], index.lookup(objs[i].project, objs[i].name));
+        }
+        EXPECT_EQ(nullptr, index.lookup(&p1, "file_100000"));
+        EXPECT_EQ(nullptr, index.lookup(nullptr, "file_0"));
+
+        for (int i=0; i<N; i+=2) {
+            index.remove(&objs[i]);
+        }
+        EXPECT_EQ((size_t)N/2, index.size());
+        EXPECT_EQ(nullptr, index.lookup(&p1, "file_0"));
+        EXPECT_EQ(&objs[1], index.lookup(&p2, "file_0"));
+    }
+
+    // a duplicate name keeps the first object, like a scan of the vector;
+    // removing the duplicate leaves the first one indexed
+    //
+    TEST_F(test_obj_index, duplicate) {
+        PROJ p;
+        OBJ a = {&p, "x"}, b = {&p, "x"};
+        OBJ_INDEX<OBJ> index;
+
+        index.add(&a);
+        index.add(&b);
+        EXPECT_EQ(&a, index.lookup(&p, "x"));
+        index.remove(&b);
+        EXPECT_EQ(&a, index.lookup(&p, "x"));
+        index.remove(&a);
+        EXPECT_EQ(nullptr, index.lookup(&p, "x"));
+    }
+}
@@ -0,0 +1,221 @@
+// This file is part of BOINC.
+// https://boinc.berkeley.edu
+// Copyright (C) 2026 University of California
+//
+// BOINC is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+// BOINC is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with BOINC.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdio>
+#include <string>
+#include <filesystem>
+
+#include "gtest/gtest.h"
+#include "filesys.h"
+#include "client/file_names.h"
+#include "client/state_journal.h"
+
+namespace test_state_journal {
+    // the journal is in the current directory, like the client's;
+    // run each test in a scratch directory
+    //
+    class test_state_journal : public ::testing::Test {
+    protected:
+        std::filesystem::path old_dir, dir;
+        void SetUp() override {
+            old_dir = std::filesystem::current_path();
+            dir = std::filesystem::temp_directory_path() / "test_state_journal";
+            std::filesystem::remove_all(dir);
+            std::filesystem::create_directories(dir);
+            std::filesystem::current_path(dir);
+        }
+        void TearDown() override {
+            std::filesystem::current_path(old_dir);
+            std::filesystem::remove_all(dir);
+        }
+    };
+
+    static void append(STATE_JOURNAL& j, const std::string& record) {
+        MFILE mf;
+        ASSERT_EQ(0, j.open(mf));
+        mf.puts(record.c_str());
+        ASSERT_EQ(0, j.close(mf));
+    }
+
+    TEST_F(test_state_journal, replay_matches_seqno) {
+        STATE_JOURNAL j;
+        char buf[256];
+
+        j.state_file_written(1000, 0);
+        EXPECT_EQ(1, j.seqno);
+        EXPECT_EQ(nullptr, j.open_for_replay());
+
+        append(j, "<journal_record>\n</journal_record>\n");
+        append(j, "<journal_record>\n</journal_record>\n");
+        EXPECT_GT(j.size, 0);
+
+        FILE* f = j.open_for_replay();
+        ASSERT_NE(nullptr, f);
+        ASSERT_NE(nullptr, fgets(buf, sizeof(buf), f));
+        EXPECT_STREQ("<journal_record>\n", buf);
+        fclose(f);
+
+        // a journal for another state file is ignored
+        //
+        STATE_JOURNAL j2;
+        j2.seqno = 2;
+        EXPECT_EQ(nullptr, j2.open_for_replay());
+
+        j.state_file_written(1000, 0);
+        EXPECT_EQ(0, j.size);
+        EXPECT_FALSE(boinc_file_exists(STATE_JOURNAL_NAME));
+    }
+
+    // a journal left from an older state file is overwritten, not appended to
+    //
+    TEST_F(test_state_journal, stale_journal_truncated) {
+        STATE_JOURNAL old, j;
+        old.seqno = 5;
+        append(old, "<journal_record>\n</journal_record>\n");
+
+        j.seqno = 7;
+        append(j, "x\n");
+        double size;
+        ASSERT_EQ(0, file_size(STATE_JOURNAL_NAME, size));
+        EXPECT_EQ(j.size, size);
+        FILE* f = j.open_for_replay();
+        ASSERT_NE(nullptr, f);
+        fclose(f);
+    }
+
+    TEST_F(test_state_journal, need_compaction) {
+        STATE_JOURNAL j;
+        j.state_file_written(1e6, 0);
+        EXPECT_FALSE(j.need_compaction(1e6));
+        j.size = 1000;
+        EXPECT_FALSE(j.need_compaction(STATE_JOURNAL_MAX_AGE - 1));
+        EXPECT_TRUE(j.need_compaction(STATE_JOURNAL_MAX_AGE + 1));
+        j.size = STATE_JOURNAL_MAX_FRAC*1e6 + 1;
+        EXPECT_TRUE(j.need_compaction(0));
+
+        // small state file: journal can grow to STATE_JOURNAL_MIN_SIZE
+        //
+        j.state_file_written(1000, 0);
+        j.size = STATE_JOURNAL_MIN_SIZE;
+        EXPECT_FALSE(j.need_compaction(0));
+    }
+
+    // counts live objects, to catch leaks and double deletes
+    //
+    struct OBJ {
+        static int count;
+        int id;
+        OBJ(int _id) {
+            id = _id;
+            count++;
+        }
+        ~OBJ() {
+            count--;
+        }
+    };
+    int OBJ::count = 0;
+
+    // replaying an active_task_set record replaces the task list
+    //
+    TEST_F(test_state_journal, replace_list) {
+        std::vector<OBJ*> list;
+        list.push_back(new OBJ(1));
+        list.push_back(new OBJ(2));
+
+        int retval = replace_list(list, [&]() {
+            // the old objects aren't visible while parsing
+            //
+            EXPECT_TRUE(list.empty());
+            list.push_back(new OBJ(3));
+            return 0;
+        });
+        EXPECT_EQ(0, retval);
+        ASSERT_EQ(1u, list.size());
+        EXPECT_EQ(3, list[0]->id);
+        EXPECT_EQ(1, OBJ::count);
+
+        // a parse error keeps the old list
+        //
+        retval = replace_list(list, [&]() {
+            list.push_back(new OBJ(4));
+            return -1;
+        });
+        EXPECT_EQ(-1, retval);
+        ASSERT_EQ(1u, list.size());
+        EXPECT_EQ(3, list[0]->id);
+        EXPECT_EQ(1, OBJ::count);
+
+        delete list[0];
+        EXPECT_EQ(0, OBJ::count);
+    }
+
+    // Bytes written per hour on a 64-core host with a 2000-job queue,
+    // running 2-minute jobs.
+    // Each job completion makes 4 state changes
+    // (task exit, cleanup, start of the next task, upload),
+    // and there's a scheduler RPC every 10 minutes.
+    // Without the journal each change rewrites the state file.
+    // With it, each change appends the changed objects
+    // (sizes as written by the client), and the state file is written
+    // on RPCs and compaction, following write_state_file_if_needed().
+    //
+    TEST_F(test_state_journal, bytes_per_hour) {
+        const int njobs = 2000, ncpus = 64;
+        const double job_bytes = 3000;      // result, workunit, files
+        const double state_file_bytes = njobs*job_bytes;
+        const double result_rec = 1000, file_rec = 600, project_rec = 2000;
+        const double task_rec = 700;
+        const double completion_interval = 120./ncpus;
+        const double rpc_interval = 600;
+
+        std::string task_set(ncpus*task_rec, 'x');
+        std::string exit_rec = task_set + std::string(result_rec + file_rec, 'x');
+        std::string cleanup_rec = exit_rec + std::string(project_rec, 'x');
+        std::string upload_rec(2*file_rec + project_rec + result_rec, 'x');
+        const std::string* changes[] = {&exit_rec, &cleanup_rec, &task_set, &upload_rec};
+
+        STATE_JOURNAL j;
+        double full_bytes = 0, next_rpc = rpc_interval;
+        int nwrites = 0;
+        j.state_file_written(state_file_bytes, 0);
+        j.bytes_written = 0;
+        for (double now=0; now<3600; now += completion_interval) {
+            bool rpc = false;
+            if (now >= next_rpc) {
+                rpc = true;
+                next_rpc += rpc_interval;
+            }
+            for (const std::string* s: changes) {
+                full_bytes += state_file_bytes;
+                if (rpc || j.need_compaction(now)) {
+                    j.state_file_written(state_file_bytes, now);
+                    nwrites++;
+                    rpc = false;
+                } else {
+                    append(j, *s);
+                }
+            }
+        }
+        printf(
+            "state file %.0f bytes\n"
+            "bytes/hour without journal: %.0f\n"
+            "bytes/hour with journal:    %.0f (%d state file writes)\n",
+            state_file_bytes, full_bytes, j.bytes_written, nwrites
+        );
+        EXPECT_LT(j.bytes_written*10, full_bytes);
+    }
+}
@@ -166,6 +166,15 @@ namespace test_str_util {
         char buf[128] = "     char space   ";
         strip_whitespace(buf);
         EXPECT_STREQ(buf, "char space");
+        strcpy(buf, "trailing\n\t ");
+        strip_whitespace(buf);
+        EXPECT_STREQ(buf, "trailing");
+        strcpy(buf, " \n ");
+        strip_whitespace(buf);
+        EXPECT_STREQ(buf, "");
+        strcpy(buf, "");
+        strip_whitespace(buf);
+        EXPECT_STREQ(buf, "");
     }
 
     TEST_F(test_str_util, strip_quotes) {
@@ -0,0 +1,129 @@
+// This file is part of BOINC.
+// https://boinc.berkeley.edu
+// Copyright (C) 2026 University of California
+//
+// BOINC is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+// BOINC is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with BOINC.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "filesys.h"
+
+#include "host_update_log.h"
+
+using std::string;
+
+namespace test_host_update_log {
+    class test_host_update_log : public ::testing::Test {};
+
+    static void read_string(const char* s, HOST_UPDATES& updates, int& nrecords, int& nbad) {
+        FILE* f = tmpfile();
+        ASSERT_NE(nullptr, f);
+        fputs(s, f);
+        rewind(f);
+        ASSERT_EQ(0, read_host_updates(f, updates, nrecords, nbad));
+        fclose(f);
+    }
+
+    static string record(DB_ID_TYPE hostid, const char* clause) {
+        char buf[256];
+        snprintf(buf, sizeof(buf), "%lu %d\n%s\n", hostid, (int)strlen(clause), clause);
+        return buf;
+    }
+
+    // two RPCs from the same host in one interval
+    //
+    TEST_F(test_host_update_log, increments_add_up) {
+        HOST_UPDATES updates;
+        int nrecords, nbad;
+        string s = record(1, " rpc_time=5, nsame_ip_addr=nsame_ip_addr+1")
+            + record(1, " rpc_time=6, nsame_ip_addr=nsame_ip_addr+1")
+            + record(2, " nsame_ip_addr=0")
+            + record(2, " nsame_ip_addr=nsame_ip_addr+1");
+        read_string(s.c_str(), updates, nrecords, nbad);
+        EXPECT_EQ(4, nrecords);
+        EXPECT_EQ(0, nbad);
+        EXPECT_EQ("6", updates[1]["rpc_time"]);
+        EXPECT_EQ("nsame_ip_addr+2", updates[1]["nsame_ip_addr"]);
+        EXPECT_EQ("1", updates[2]["nsame_ip_addr"]);
+    }
+
+    TEST_F(test_host_update_log, counters_logged_as_increments) {
+        const char* path = "test_host_update_log";
+        HOST host = HOST(), initial_host;
+        HOST_UPDATES updates;
+        int nrecords, nbad;
+
+        host.id = 7;
+        host.nsame_ip_addr = 4;
+        host.nresults_today = 0;
+        initial_host = host;
+        initial_host.nsame_ip_addr = 3;
+        initial_host.nresults_today = 10;
+        boinc_delete_file(path);
+        ASSERT_EQ(0, write_host_update(path, host, initial_host,
+            " rpc_time=10, nsame_ip_addr=4, nresults_today=0"
+        ));
+        FILE* f = fopen(path, "r");
+        ASSERT_NE(nullptr, f);
+        ASSERT_EQ(0, read_host_updates(f, updates, nrecords, nbad));
+        fclose(f);
+        boinc_delete_file(path);
+
+        EXPECT_EQ(1, nrecords);
+        EXPECT_EQ("10", updates[7]["rpc_time"]);
+        EXPECT_EQ("nsame_ip_addr+1", updates[7]["nsame_ip_addr"]);
+
+        // reset to zero is logged as is
+        EXPECT_EQ("0", updates[7]["nresults_today"]);
+    }
+
+    // a partial record doesn't lose the ones after it
+    //
+    TEST_F(test_host_update_log, skip_bad_record) {
+        HOST_UPDATES updates;
+        int nrecords, nbad;
+        string s = record(1, " rpc_time=5")
+            + "2 40\n rpc_time=6, d_fr"
+            + record(3, " rpc_time=7")
+            + "garbage\n"
+            + record(4, " rpc_time=8");
+        read_string(s.c_str(), updates, nrecords, nbad);
+        EXPECT_EQ(3, nrecords);
+        EXPECT_EQ(2, nbad);
+        EXPECT_EQ(3u, updates.size());
+        EXPECT_EQ("7", updates[3]["rpc_time"]);
+        EXPECT_EQ("8", updates[4]["rpc_time"]);
+        EXPECT_EQ(0u, updates.count(2));
+    }
+
+    TEST_F(test_host_update_log, write_read) {
+        HOST_UPDATES updates, updates2;
+        int nrecords, nbad;
+        updates[1]["rpc_time"] = "5";
+        updates[1]["venue"] = "'home, \\'x\\''";
+        updates[2]["nsame_ip_addr"] = "nsame_ip_addr+3";
+        FILE* f = tmpfile();
+        ASSERT_NE(nullptr, f);
+        ASSERT_EQ(0, write_host_updates(f, updates));
+        rewind(f);
+        ASSERT_EQ(0, read_host_updates(f, updates2, nrecords, nbad));
+        fclose(f);
+        EXPECT_EQ(2, nrecords);
+        EXPECT_EQ(0, nbad);
+        EXPECT_EQ(updates, updates2);
+    }
+}
@@ -402,6 +402,20 @@ int create_work2(
         wu.id = wu.db->insert_id();
     }
 
+    // tell the transitioner to create the job's instances.
+    // With query_string the caller inserts the job;
+    // create_work --stdin queues those after its bulk insert.
+    //
+    if (!query_string && config_loc.wu_queue && !wu.transitioner_flags) {
+        DB_WU_QUEUE wu_queue(wu.db);
+        retval = wu_queue.add(WU_QUEUE_TRANSITIONER, wu.id);
+        if (retval) {
+            boinc::fprintf(stderr,
+                "create_work: can't queue WU for transitioner: %s\n",
+                boincerror(retval)
+            );
+        }
+    }
     return 0;
 }
 
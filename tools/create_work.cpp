@@ -46,6 +46,7 @@
 #include <ctime>
 #include <string>
 #include <map>
+#include <vector>
 #include <sys/param.h>
 #include <unistd.h>
 
@@ -67,6 +68,7 @@
 
 using std::string;
 using std::map;
+using std::vector;
 
 bool verbose = false;
 bool continue_on_error = false;
@@ -265,6 +267,37 @@ void check_buffer(char *p, size_t len) {
     }
 }
 
+// insert a batch of jobs created from --stdin lines.
+// A bulk insert doesn't give the jobs' IDs,
+// so queue them for the transitioner by name.
+//
+void insert_batch(string& values, vector<string>& names) {
+    DB_WORKUNIT wu;
+    int retval = wu.insert_batch(values);
+    if (retval) {
+        fprintf(stderr,
+            "wu.insert_batch() failed: %d; size %d\n",
+            retval, (int)values.size()
+        );
+        fprintf(stderr,
+            "MySQL error: %s\n", boinc_db.error_string()
+        );
+        exit(1);
+    }
+    if (config.wu_queue && names.size()) {
+        DB_WU_QUEUE wu_queue;
+        retval = wu_queue.add_names(WU_QUEUE_TRANSITIONER, names);
+        if (retval) {
+            fprintf(stderr,
+                "can't queue jobs for transitioner: %s\n",
+                boinc_db.error_string()
+            );
+        }
+    }
+    values.clear();
+    names.clear();
+}
+
 int main(int argc, char** argv) {
     DB_APP app;
     int retval;
@@ -500,7 +533,7 @@ int main(int argc, char** argv) {
             // for max efficiency, do them all in one big SQL query
             //
             string values;
-            DB_WORKUNIT wu;
+            vector<string> names;
             int _argc;
             char* _argv[100], value_buf[MAX_QUERY_LEN];
 
@@ -569,35 +602,18 @@ int main(int argc, char** argv) {
                 } else {
                     values = value_buf;
                 }
+                if (!jd2.wu.transitioner_flags) {
+                    names.push_back(jd2.wu.name);
+                }
                 // MySQL can handles queries at least 1 MB
                 //
                 int n = strlen(value_buf);
                 if (values.size() + 2*n > 1000000) {
-                    retval = wu.insert_batch(values);
-                    if (retval) {
-                        fprintf(stderr,
-                            "wu.insert_batch() failed: %d; size %d\n",
-                            retval, (int)values.size()
-                        );
-                        fprintf(stderr,
-                            "MySQL error: %s\n", boinc_db.error_string()
-                        );
-                        exit(1);
-                    }
-                    values.clear();
+                    insert_batch(values, names);
                 }
             }
             if (values.size()) {
-                retval = wu.insert_batch(values);
-                if (retval) {
-                    fprintf(stderr,
-                        "wu.insert_batch() failed: %d\n", retval
-                    );
-                    fprintf(stderr,
-                        "MySQL error: %s\n", boinc_db.error_string()
-                    );
-                    exit(1);
-                }
+                insert_batch(values, names);
             }
         }
     } else {